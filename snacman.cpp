@@ -1,20 +1,94 @@
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <climits>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <list>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 #include <map>
 #include <set>
+#include <string>
+
+// Level memory comes from std::pmr where the standard library has it. Older
+// ones, like the libc++ in the emsdk the web build uses, predate
+// <memory_resource>, so there the same names stand for plain heap
+// allocation, and a level's memory goes back container by container rather
+// than all at once.
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#else
+namespace pmr {
+    struct memory_resource {
+        virtual ~memory_resource() {}
+    };
+
+    inline memory_resource* get_default_resource() {
+        static memory_resource heap;
+        return &heap;
+    }
+
+    struct monotonic_buffer_resource : memory_resource {};
+
+    struct unsynchronized_pool_resource : memory_resource {
+        void release() {}
+    };
+
+    template <class T>
+    struct polymorphic_allocator : std::allocator<T> {
+        memory_resource* memory;
+
+        polymorphic_allocator(memory_resource* newMemory = get_default_resource()) : memory(newMemory) {}
+
+        template <class U>
+        polymorphic_allocator(const polymorphic_allocator<U>& other) : memory(other.memory) {}
+
+        template <class U>
+        struct rebind {
+            typedef polymorphic_allocator<U> other;
+        };
+
+        memory_resource* resource() const {
+            return memory;
+        }
+    };
+
+    template <class T>
+    using vector = std::vector<T, polymorphic_allocator<T>>;
+    template <class T>
+    using list = std::list<T, polymorphic_allocator<T>>;
+    template <class T>
+    using deque = std::deque<T, polymorphic_allocator<T>>;
+    template <class T>
+    using set = std::set<T, std::less<T>, polymorphic_allocator<T>>;
+    using string = std::basic_string<char, std::char_traits<char>, polymorphic_allocator<char>>;
+}
+#endif
 
 #include "raylib.h"
 #include "raymath.h"
 #if defined(PLATFORM_WEB)
 #include "emscripten.h"
 #endif
+// Spectating needs a pipe or file to talk through, which the web build lacks
+#if !defined(PLATFORM_WEB) && (defined(__unix__) || defined(__APPLE__))
+#define SNAPSHOT_STREAMS
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #define WIDTH 800
 #define HEIGHT 600
@@ -33,6 +107,13 @@
 
 using namespace std;
 
+// Per-level heap. The game's map, critters and rewind history are built on
+// it (see mainData's constructor), and initEverything hands the whole thing
+// back in one go when a level is torn down. Everything else, the bot's
+// copies of the game included, uses the ordinary heap.
+pmr::unsynchronized_pool_resource levelMemory;
+typedef pmr::vector<pmr::string> levelMap;
+
 struct V2 {
     int x, y;
 
@@ -88,6 +169,15 @@ struct compass {
         return cardinal[index];
     }
 
+    int cardinalIndex(V2 current) {
+        for (int i = 0; i < 4; i++) {
+            if (cardinal[i] == current) {
+                return i;
+            }
+        }
+        return 0;
+    }
+
     int cardinalToDegrees(V2& current) {
         if (current == cardinal[0]) {
             return 270;
@@ -112,60 +202,297 @@ struct segment {
         pos(newPos), forward(newForward), down(newDown), clockwise(newClockwise) {}
 };
 
-struct critter {
-    compass c;
-    vector<string> moveMap;
-    list<segment> segments;
+bool sameSegment(const segment& a, const segment& b) {
+    return a.pos.x == b.pos.x && a.pos.y == b.pos.y && a.forward.x == b.forward.x && a.forward.y == b.forward.y
+        && a.down.x == b.down.x && a.down.y == b.down.y && a.clockwise == b.clockwise;
+}
+
+// Tiles and what they used to hold
+typedef pmr::vector<pair<V2, char>> tileChanges;
+
+// One bit per tile, each row padded out to whole 64-bit words, so a tile's
+// neighbours can be worked out 64 tiles at a time with shifts and ORs
+struct bitboard {
+    int width = 0;
+    int height = 0;
+    int words = 0;
+    // Rows outside [firstRow, lastRow] are known to be empty
+    int firstRow = 0;
+    int lastRow = -1;
+    pmr::vector<uint64_t> bits;
+
+    bitboard(pmr::memory_resource* memory = pmr::get_default_resource()) : bits(memory) {}
+
+    void resize(int newWidth, int newHeight) {
+        width = newWidth;
+        height = newHeight;
+        words = (width + 63) / 64;
+        firstRow = 0;
+        lastRow = height - 1;
+        bits.assign(words * height, 0);
+    }
+
+    uint64_t* row(int y) {
+        return &bits[y * words];
+    }
+
+    void set(V2 v) {
+        row(v.y)[v.x / 64] |= (uint64_t)1 << (v.x % 64);
+    }
+
+    bool test(V2 v) {
+        return row(v.y)[v.x / 64] >> (v.x % 64) & 1;
+    }
+
+    void fromMap(levelMap& map, char tile) {
+        int newWidth = 0;
+        for (pmr::string& line : map) {
+            newWidth = max(newWidth, (int)line.size());
+        }
+        resize(newWidth, map.size());
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < map[y].size(); x++) {
+                if (map[y][x] == tile) {
+                    set(V2(x, y));
+                }
+            }
+        }
+    }
+
+    // out = in, plus the tiles either side of it
+    void spread(uint64_t* in, uint64_t* out) {
+        for (int w = 0; w < words; w++) {
+            out[w] = in[w] | in[w] << 1 | in[w] >> 1;
+            if (w > 0) {
+                out[w] |= in[w - 1] >> 63;
+            }
+            if (w + 1 < words) {
+                out[w] |= in[w + 1] << 63;
+            }
+        }
+    }
+
+    // Extend the seed bits in words lo to hi to the whole runs of mask they
+    // touch: one sweep each way, doubling the reach every step within a word
+    // while there's still a run to grow, and going on past lo or hi only while
+    // a run does. Bits that weren't
+    // there before also go into fresh. Returns the first and last word that
+    // could have changed.
+    pair<int, int> fillRow(uint64_t* seed, uint64_t* mask, uint64_t* fresh, int lo, int hi) {
+        uint64_t carry = 0;
+        int last = hi;
+        for (int w = lo; w < words; w++) {
+            uint64_t gen = seed[w] | (carry & mask[w]);
+            uint64_t pro = mask[w];
+            for (int shift = 1; shift < 64 && (mask[w] & ~gen & gen << 1); shift *= 2) {
+                gen |= pro & (gen << shift);
+                pro &= pro << shift;
+            }
+            if (w > hi && gen == seed[w]) {
+                break;
+            }
+            fresh[w] |= gen & ~seed[w];
+            seed[w] = gen;
+            carry = gen >> 63;
+            last = w;
+        }
+        carry = 0;
+        int first = lo;
+        for (int w = last; w >= 0; w--) {
+            uint64_t gen = seed[w] | (carry & mask[w]);
+            uint64_t pro = mask[w];
+            for (int shift = 1; shift < 64 && (mask[w] & ~gen & gen >> 1); shift *= 2) {
+                gen |= pro & (gen >> shift);
+                pro &= pro >> shift;
+            }
+            if (w < lo && gen == seed[w]) {
+                break;
+            }
+            fresh[w] |= gen & ~seed[w];
+            seed[w] = gen;
+            carry = gen << 63;
+            first = w;
+        }
+        return {first, last};
+    }
+
+    // Become the 8-connected group of mask's bits that start belongs to.
+    // Rows that gain bits go on a worklist, and only those new bits get
+    // passed on to the rows either side, so no bit is passed on twice
+    // however many times the group doubles back on itself.
+    void flood(bitboard& mask, V2 start) {
+        resize(mask.width, mask.height);
+        bitboard fresh(bits.get_allocator().resource());
+        fresh.resize(width, height);
+        // The words each row's fresh bits lie in; first > second if none
+        const pair<int, int> none(words, -1);
+        pmr::vector<pair<int, int>> span(height, none, bits.get_allocator());
+        pmr::vector<int> worklist(bits.get_allocator());
+        auto gained = [&](int y, pair<int, int> changed) {
+            if (span[y].first > span[y].second) {
+                worklist.push_back(y);
+            }
+            span[y] = {min(span[y].first, changed.first), max(span[y].second, changed.second)};
+            firstRow = min(firstRow, y);
+            lastRow = max(lastRow, y);
+        };
+        set(start);
+        fresh.set(start);
+        firstRow = lastRow = start.y;
+        gained(start.y, fillRow(row(start.y), mask.row(start.y), fresh.row(start.y), start.x / 64, start.x / 64));
+        while (!worklist.empty()) {
+            int from = worklist.back();
+            worklist.pop_back();
+            int lo = span[from].first;
+            int hi = span[from].second;
+            span[from] = none;
+            uint64_t* passing = fresh.row(from);
+            for (int y = from - 1; y <= from + 1; y += 2) {
+                if (y < 0 || y >= height) {
+                    continue;
+                }
+                uint64_t* here = row(y);
+                uint64_t* allowed = mask.row(y);
+                int addLo = words;
+                int addHi = -1;
+                for (int w = max(0, lo - 1); w <= min(words - 1, hi + 1); w++) {
+                    uint64_t edge = passing[w] | passing[w] << 1 | passing[w] >> 1;
+                    if (w > 0) {
+                        edge |= passing[w - 1] >> 63;
+                    }
+                    if (w + 1 < words) {
+                        edge |= passing[w + 1] << 63;
+                    }
+                    uint64_t add = edge & allowed[w] & ~here[w];
+                    if (add) {
+                        here[w] |= add;
+                        fresh.row(y)[w] |= add;
+                        addLo = min(addLo, w);
+                        addHi = w;
+                    }
+                }
+                if (addHi >= 0) {
+                    gained(y, fillRow(here, allowed, fresh.row(y), addLo, addHi));
+                }
+            }
+            fill(passing + lo, passing + hi + 1, 0);
+        }
+    }
+
+    // Become every tile touching (diagonals included) a bit of from, except
+    // the blocked ones
+    void dilate(bitboard& from, bitboard& blocked) {
+        resize(from.width, from.height);
+        firstRow = max(0, from.firstRow - 1);
+        lastRow = min(height - 1, from.lastRow + 1);
+        // Spreading sideways gives the same whether it's done before or after
+        // an OR, so the rows above, at and below are ORed first and spread once
+        pmr::vector<uint64_t> near(words, 0, bits.get_allocator());
+        for (int y = firstRow; y <= lastRow; y++) {
+            uint64_t* out = row(y);
+            fill(near.begin(), near.end(), 0);
+            for (int fromRow = max(from.firstRow, y - 1); fromRow <= min(from.lastRow, y + 1); fromRow++) {
+                uint64_t* in = from.row(fromRow);
+                for (int w = 0; w < words; w++) {
+                    near[w] |= in[w];
+                }
+            }
+            spread(near.data(), out);
+            uint64_t* wall = blocked.row(y);
+            for (int w = 0; w < words; w++) {
+                out[w] &= ~wall[w];
+            }
+        }
+    }
+};
+
+// A spider only chases snake it can reach along its own path, and never
+// leaves the patch of path it starts on, so while its patch holds no snake
+// it can't do anything. Each distinct patch is a zone.
+struct zoneLayout {
+    int width = 0;
+    int count = 0;
+    // Tile i = y * width + x is in zones zoneList[firstZone[i]] up to but
+    // not including zoneList[firstZone[i + 1]]
+    pmr::vector<int> firstZone;
+    pmr::vector<int> zoneList;
+
+    zoneLayout(pmr::memory_resource* memory) : firstZone(memory), zoneList(memory) {}
+};
+
+// How many snake tiles each zone holds. Spiders in empty zones sleep.
+struct spiderZones {
+    // Fixed for the level, so copies of the game share it
+    shared_ptr<const zoneLayout> layout;
+    pmr::vector<int> snakeTiles;
 
-    critter() {}
+    spiderZones(pmr::memory_resource* memory = pmr::get_default_resource()) : snakeTiles(memory) {}
 
-    critter(V2 pos, vector<string>& map) {
+    bool occupied(int zone) {
+        return snakeTiles[zone] > 0;
+    }
+
+    // Tile v is about to go from was to now
+    void changed(V2 v, char was, char now) {
+        if (!layout || (was == SNAKE) == (now == SNAKE)) {
+            return;
+        }
+        int i = v.y * layout->width + v.x;
+        for (int z = layout->firstZone[i]; z < layout->firstZone[i + 1]; z++) {
+            snakeTiles[layout->zoneList[z]] += now == SNAKE ? 1 : -1;
+        }
+    }
+};
+
+struct critter {
+    compass c;
+    // A spider's never changes, so copies of it share the one map; the
+    // snake's changes as it crosses, and copies of the game copy it. Drawn
+    // from the same memory as segments, map and all.
+    shared_ptr<levelMap> moveMap;
+    pmr::list<segment> segments;
+    // No sounds or messages, for the bot's imaginary critters
+    bool quiet = false;
+
+    critter(pmr::memory_resource* memory = pmr::get_default_resource()) :
+        moveMap(allocate_shared<levelMap>(pmr::polymorphic_allocator<levelMap>(memory))), segments(memory) {}
+
+    // Draws from the same memory as map
+    critter(V2 pos, levelMap& map, bitboard& walls) : critter(map.get_allocator().resource()) {
         segment newHead;
         for (int i = 0; i < 4; i++) {
             V2 adj = pos + c.cardinal[i];
             if (map[adj.y][adj.x] == WALL) {
                 newHead = segment(pos, c.get(c.cardinal[i], 1), c.cardinal[i], c.clockwise);
-                makeMoveMap(adj, map);
+                makeMoveMap(adj, map, walls);
             }
         }
         segments.push_front(newHead);
     }
 
     bool ok(V2 v) {
-        return v.y >= 0 && v.y < moveMap.size() && v.x >= 0 && v.x < moveMap[v.y].size();
-    }
-
-    // Generate which tiles the snake can traverse (adjacent to wall)
-    void makeMoveMap(V2 start, vector<string>& map) {
-        moveMap = map;
-        list<V2> Q;
-        Q.push_back(start);
-        moveMap[start.y][start.x] = PATHWALL;
-        while (!Q.empty()) {
-            V2 next = *Q.begin();
-            Q.pop_front();
-            for (V2 plus : {V2(1, 0), V2(1, 1), V2(1, -1), V2(0, 1), V2(0, -1), V2(-1, 0), V2(-1, -1), V2(-1, 1)}) {
-                V2 adj = next + plus;
-                if (ok(adj)) {
-                    if (moveMap[adj.y][adj.x] == WALL) {
-                        moveMap[adj.y][adj.x] = PATHWALL;
-                        Q.push_back(adj);
-                    }
-                    else if (moveMap[adj.y][adj.x] != PATHWALL) {
-                        moveMap[adj.y][adj.x] = PATH;
-                    }
+        return v.y >= 0 && v.y < moveMap->size() && v.x >= 0 && v.x < (*moveMap)[v.y].size();
+    }
+
+    // Generate which tiles the snake can traverse (adjacent to wall): the
+    // wall group we're on becomes PATHWALL and everything touching it PATH
+    void makeMoveMap(V2 start, levelMap& map, bitboard& walls) {
+        *moveMap = map;
+        // Kept from one call to the next, one pair per thread, so a big map's
+        // boards aren't allocated and faulted in afresh every time
+        static thread_local bitboard group;
+        static thread_local bitboard path;
+        group.flood(walls, start);
+        path.dilate(group, walls);
+        for (int row = path.firstRow; row <= path.lastRow; row++) {
+            for (int w = 0; w < path.words; w++) {
+                for (uint64_t b = group.row(row)[w]; b; b &= b - 1) {
+                    (*moveMap)[row][w * 64 + __builtin_ctzll(b)] = PATHWALL;
                 }
-            }
-        }
-        for (int row = 0; row < moveMap.size(); row++) {
-            for (int col = 0; col < moveMap[row].size(); col++) {
-                V2 pos(col, row);
-                if (moveMap[pos.y][pos.x] == APPLE || moveMap[pos.y][pos.x] == EMPTY || moveMap[pos.y][pos.x] == SNAKE || moveMap[pos.y][pos.x] == ENEMY) {
-                    for (V2 diag : {V2(1, 1), V2(1, -1), V2(-1, 1), V2(-1, -1)}) {
-                        V2 adj = pos + diag;
-                        if (ok(adj) && moveMap[adj.y][adj.x] == PATHWALL) {
-                            moveMap[pos.y][pos.x] = PATH;
-                        }
+                for (uint64_t b = path.row(row)[w]; b; b &= b - 1) {
+                    int col = w * 64 + __builtin_ctzll(b);
+                    if (col < (*moveMap)[row].size()) {
+                        (*moveMap)[row][col] = PATH;
                     }
                 }
             }
@@ -183,9 +510,9 @@ struct critter {
             V2 nextDown = c.get(nextForward, -1);
             V2 nextPos = segments.begin()->pos + nextForward;
             V2 nextWall = nextPos + nextDown;
-            if (moveMap[nextPos.y][nextPos.x] == PATH) {
+            if ((*moveMap)[nextPos.y][nextPos.x] == PATH) {
                 // +8 points for not going around the path the wrong way
-                int newScore = moveMap[nextWall.y][nextWall.x] == EMPTY ? 0 : 8;
+                int newScore = (*moveMap)[nextWall.y][nextWall.x] == EMPTY ? 0 : 8;
                 // +4 points for not going backwards
                 newScore += i != 2 ? 4 : 0;
                 // +2 points for not overlapping previous snake
@@ -197,7 +524,7 @@ struct critter {
                     }
                 }
                 // +1 points for adhering to wall
-                newScore += moveMap[nextWall.y][nextWall.x] == PATHWALL ? 1 : 0;
+                newScore += (*moveMap)[nextWall.y][nextWall.x] == PATHWALL ? 1 : 0;
                 if (newScore > score) {
                     next = segment(nextPos, nextForward, nextDown, c.clockwise);
                     score = newScore;
@@ -208,11 +535,23 @@ struct critter {
     }
 
     virtual void render(bool debug) {}
+
+    virtual void unloadTextures() {}
 };
 
 
+// What one snake::doTick did, enough to take it back
+struct snakeUndo {
+    bool dequeued = false;
+    tileChanges tiles;
+    // Spliced out of snake::segments, so must share its memory
+    pmr::list<segment> shed;
+
+    snakeUndo(pmr::memory_resource* memory) : tiles(memory), shed(memory) {}
+};
+
 struct snake : public critter {
-    list<segment> moveQueue;
+    pmr::list<segment> moveQueue;
     unordered_map<string, Texture2D> textures;
     Sound yerbSound;
     int snakeSize = 1;
@@ -229,14 +568,25 @@ struct snake : public critter {
         }
     }
 
-    snake() {}
+    snake(pmr::memory_resource* memory = pmr::get_default_resource()) : critter(memory), moveQueue(memory) {}
 
-    snake(V2 head, vector<string>& map) : critter(head, map) {
+    snake(V2 head, levelMap& map, bitboard& walls) : critter(head, map, walls), moveQueue(map.get_allocator()) {
         initTextures();
         yerbSound = LoadSound("resources/sound/yerb.ogg");
     }
 
-    void doTick(vector<string>& map) {
+    void unloadTextures() {
+        for (auto& tex : textures) {
+            UnloadTexture(tex.second);
+        }
+        textures.clear();
+        UnloadSound(yerbSound);
+    }
+
+    void doTick(levelMap& map, spiderZones& zones, snakeUndo* undo = nullptr) {
+        if (undo) {
+            undo->dequeued = !moveQueue.empty();
+        }
         //Snake movement: Wall following
         if (!moveQueue.empty()) {
             //Move queue is filled when we start crossing a gap
@@ -250,19 +600,68 @@ struct snake : public critter {
         V2 head = segments.begin()->pos;
         if (map[head.y][head.x] == APPLE) {
             snakeSize++;
-            PlaySound(yerbSound);
+            if (!quiet) {
+                PlaySound(yerbSound);
+            }
+        }
+        if (undo) {
+            undo->tiles.push_back({head, map[head.y][head.x]});
         }
+        zones.changed(head, map[head.y][head.x], SNAKE);
         map[head.y][head.x] = SNAKE;
         while (segments.size() > snakeSize) {
             V2 tail = segments.rbegin()->pos;
+            if (undo) {
+                undo->tiles.push_back({tail, map[tail.y][tail.x]});
+                undo->shed.splice(undo->shed.end(), segments, prev(segments.end()));
+            }
+            else {
+                segments.pop_back();
+            }
+            zones.changed(tail, map[tail.y][tail.x], EMPTY);
             map[tail.y][tail.x] = EMPTY;
-            segments.pop_back();
         }
     }
 
-    void handleInput(vector<string>& map) {
+    void undoTick(levelMap& map, spiderZones& zones, snakeUndo& undo) {
+        for (auto tile = undo.tiles.rbegin(); tile != undo.tiles.rend(); tile++) {
+            zones.changed(tile->first, map[tile->first.y][tile->first.x], tile->second);
+            map[tile->first.y][tile->first.x] = tile->second;
+        }
+        while (!undo.shed.empty()) {
+            segments.splice(segments.end(), undo.shed, prev(undo.shed.end()));
+        }
+        if (undo.dequeued) {
+            moveQueue.push_front(segments.front());
+        }
+        segments.pop_front();
+    }
+
+    // Only the tiles that differ from the map, since that's where moveMap
+    // came from and the map will be back in this state when it's restored
+    void rememberMoveMap(levelMap& map, tileChanges& out) {
+        out.clear();
+        for (int row = 0; row < moveMap->size(); row++) {
+            for (int col = 0; col < (*moveMap)[row].size(); col++) {
+                if ((*moveMap)[row][col] != map[row][col]) {
+                    out.push_back({V2(col, row), (*moveMap)[row][col]});
+                }
+            }
+        }
+    }
+
+    void restoreMoveMap(levelMap& map, tileChanges& remembered) {
+        *moveMap = map;
+        for (auto& tile : remembered) {
+            (*moveMap)[tile.first.y][tile.first.x] = tile.second;
+        }
+    }
+
+    // Returns true if we set off for the opposite wall. oldMoveMap, if given,
+    // gets the move map we're leaving behind.
+    bool cross(levelMap& map, bitboard& walls, tileChanges* oldMoveMap = nullptr) {
         V2 head = segments.begin()->pos;
-        if (IsKeyPressed(KEY_SPACE) && moveQueue.empty()) {
+        if (moveQueue.empty()) {
             //Crossing to opposite wall
             V2 up = c.get(segments.begin()->down, 2);
             bool canCross = false;
@@ -278,7 +677,10 @@ struct snake : public critter {
                 }
                 if (map[swapWall.y][swapWall.x] == WALL) {
                     canCross = true;
-                    makeMoveMap(swapWall, map);
+                    if (oldMoveMap) {
+                        rememberMoveMap(map, *oldMoveMap);
+                    }
+                    makeMoveMap(swapWall, map, walls);
                     //Following opposite wall now
                     c.reverse();
                     break;
@@ -291,17 +693,19 @@ struct snake : public critter {
             if (!canCross) {
                 moveQueue.clear();
             }
+            return canCross;
         }
+        return false;
     }
 
     void render(bool debug) {
         if (debug) {
-            for (int row = 0; row < moveMap.size(); row++) {
-                for (int col = 0; col < moveMap[row].size(); col++) {
-                    if (moveMap[row][col] == PATHWALL) {
+            for (int row = 0; row < moveMap->size(); row++) {
+                for (int col = 0; col < (*moveMap)[row].size(); col++) {
+                    if ((*moveMap)[row][col] == PATHWALL) {
                         DrawRectangle(GRID * col, GRID * row, GRID, GRID, BLUE);
                     }
-                    else if (moveMap[row][col] == PATH) {
+                    else if ((*moveMap)[row][col] == PATH) {
                         DrawRectangle(GRID * col, GRID * row, GRID, GRID, Fade(GREEN, 0.5));
                     }
                 }
@@ -374,7 +778,7 @@ struct snake : public critter {
                     // draw the indicator on the inside of the wall we are on
                     int x = logicalPos.x * GRID + (adj.x < 0 ? GRID - INDICATOR_THICKNESS : 0);
                     int y = logicalPos.y * GRID + (adj.y < 0 ? GRID - INDICATOR_THICKNESS : 0);
-                    if (moveMap[logicalPos.y][logicalPos.x] == PATHWALL) {
+                    if ((*moveMap)[logicalPos.y][logicalPos.x] == PATHWALL) {
                         DrawRectangle(x, y , w, h, YELLOW);
                     }
                 }
@@ -392,39 +796,87 @@ struct snake : public critter {
 struct spider : public critter {
 
     Texture2D tex;
+    int id = 0;
+    // Index into mainData::zones
+    int zone = -1;
     void initTextures() {
         tex = LoadTexture("resources/exam.png");
     }
 
-    spider(V2 pos, vector<string>& map) : critter(pos, map) {
+    // Spectators only need something to draw; position comes from the stream
+    spider() {
+        initTextures();
+    }
+
+    spider(V2 pos, levelMap& map, bitboard& walls) : critter(pos, map, walls) {
         initTextures();
         segments.push_front(getNextSegment());
     }
 
-    bool doTick(vector<string>& map) {
+    void unloadTextures() {
+        UnloadTexture(tex);
+    }
+
+    // Every tile doTick could look at for snake: the patch of path we're
+    // on, plus wherever our head and tail are now
+    void findReach(bitboard& out, int width) {
+        out.resize(width, moveMap->size());
+        pmr::monotonic_buffer_resource scratch;
+        pmr::vector<V2> Q(&scratch);
+        Q.push_back(segments.begin()->pos);
+        for (size_t front = 0; front < Q.size(); front++) {
+            for (int i = 0; i < 4; i++) {
+                V2 adj = Q[front] + c.cardinal[i];
+                if (ok(adj) && (*moveMap)[adj.y][adj.x] == PATH && !out.test(adj)) {
+                    out.set(adj);
+                    Q.push_back(adj);
+                }
+            }
+        }
+        for (segment& seg : segments) {
+            out.set(seg.pos);
+        }
+    }
+
+    bool doTick(levelMap& map) {
         //Spider has 2 segments (to prevent passing through length-1 snake.)
         // Check if either of those segments touching snake.
         V2 head = segments.begin()->pos;
         V2 tail = segments.rbegin()->pos;
         if (map[head.y][head.x] == SNAKE || map[tail.y][tail.x] == SNAKE) {
-            cout << "You got caught by a spider!\n";
+            if (!quiet) {
+                cout << "You got caught by a spider!\n";
+            }
             return true;
         }
-        // Use DFS to search for snake markings
-        list<V2> Q;
-        Q.push_back(segments.begin()->pos);
-        unordered_map<int, V2> parents;
-        while (!Q.empty()) {
-            V2 next = *Q.begin();
-            Q.pop_front();
+        // Use BFS to search for snake markings. Every tile reached remembers
+        // which cardinal it was reached along, -1 if it hasn't been yet. The
+        // head starts out reached, so it's never queued twice.
+        const signed char START = 4;
+        int width = 0;
+        for (pmr::string& row : *moveMap) {
+            width = max(width, (int)row.size());
+        }
+        pmr::monotonic_buffer_resource scratch;
+        pmr::vector<V2> Q(&scratch);
+        pmr::vector<signed char> reachedBy(width * moveMap->size(), -1, &scratch);
+        // Only for tiles other than the head
+        auto parent = [&](V2 v) {
+            return v - c.cardinal[reachedBy[v.y * width + v.x]];
+        };
+        reachedBy[head.y * width + head.x] = START;
+        Q.push_back(head);
+        for (size_t front = 0; front < Q.size(); front++) {
+            V2 next = Q[front];
             for (int i = 0; i < 4; i++) {
                 V2 adj = next + c.cardinal[i];
-                if (ok(adj) && moveMap[adj.y][adj.x] == PATH && parents.count(adj.hash()) == 0) {
-                    parents[adj.hash()] = next;
+                if (ok(adj) && (*moveMap)[adj.y][adj.x] == PATH && reachedBy[adj.y * width + adj.x] < 0) {
+                    reachedBy[adj.y * width + adj.x] = i;
                     Q.push_back(adj);
                     if (map[adj.y][adj.x] == SNAKE) {
-                        while (parents[next.hash()] != head && next != head) {
-                            next = parents[next.hash()];
+                        // Walk back to the first step away from the head
+                        while (next != head && parent(next) != head) {
+                            next = parent(next);
                         }
                         segments.begin()->forward = next - head;
                         segment next = getNextSegment();
@@ -442,9 +894,9 @@ struct spider : public critter {
         /* DrawCircle((head.x + 0.5) * GRID, (head.y + 0.5) * GRID, 0.5 * GRID, PURPLE); */
         DrawTexture(tex, (head.x+0.5)*GRID-tex.width/2, (head.y+0.5)*GRID-tex.height/2,  WHITE);
         if (debug) {
-            for (int row = 0; row < moveMap.size(); row++) {
-                for (int col = 0; col < moveMap[row].size(); col++) {
-                    if (moveMap[row][col] == PATH) {
+            for (int row = 0; row < moveMap->size(); row++) {
+                for (int col = 0; col < (*moveMap)[row].size(); col++) {
+                    if ((*moveMap)[row][col] == PATH) {
                         DrawRectangle(GRID * col, GRID * row, GRID, GRID, Fade(PURPLE, 0.5));
                     }
                 }
@@ -453,11 +905,119 @@ struct spider : public critter {
     }
 };
 
+// Ticks kept for rewinding: 20 seconds at normal speed
+#define REWIND_TICKS 50
+// Ticks taken back per press of Z
+#define REWIND_STEP 3
+
+// Everything one tick changed, plus the crossings made since the tick
+// before it, so it can be played backwards
+struct tickUndo {
+    int snakeSize = 0;
+    int totalApples = 0;
+    snakeUndo snake;
+    // Index before the tick, then the spider's head and tail
+    pmr::vector<pair<int, pair<segment, segment>>> spiderMoves;
+    pmr::list<spider> caught;
+    pmr::vector<int> caughtAt;
+    // Crossings only ever need undoing all together, so the first one's
+    // move map and how many there were is all we keep
+    int crossings = 0;
+    tileChanges moveMapBefore;
+
+    // caught and snake.shed trade list nodes with the game's, and
+    // moveMapBefore with rewindBuffer's, so they all share one memory
+    tickUndo(pmr::memory_resource* memory) : snake(memory), spiderMoves(memory), caught(memory),
+        caughtAt(memory), moveMapBefore(memory) {}
+};
+
+struct rewindBuffer {
+    pmr::deque<tickUndo> ticks;
+    // Crossings made since the last tick
+    int crossings = 0;
+    tileChanges moveMapBefore;
+
+    rewindBuffer(pmr::memory_resource* memory) : ticks(memory), moveMapBefore(memory) {}
+
+    void forgetOldest() {
+        for (spider& enemy : ticks.front().caught) {
+            enemy.unloadTextures();
+        }
+        ticks.pop_front();
+    }
+
+    tickUndo& beginTick(int snakeSize, int totalApples) {
+        if (ticks.size() == REWIND_TICKS) {
+            forgetOldest();
+        }
+        ticks.emplace_back(ticks.get_allocator().resource());
+        tickUndo& undo = ticks.back();
+        undo.snakeSize = snakeSize;
+        undo.totalApples = totalApples;
+        undo.crossings = crossings;
+        undo.moveMapBefore.swap(moveMapBefore);
+        crossings = 0;
+        return undo;
+    }
+
+    void unloadTextures() {
+        while (!ticks.empty()) {
+            forgetOldest();
+        }
+    }
+};
+
+// The frame rate drops while nothing can happen without a key press. Every
+// frame that does run still draws the whole screen: raylib 3.5's EndDrawing
+// always swaps buffers, and a back buffer nobody drew into could hold
+// anything. The canvas itself is only rebuilt on ticks, as ever.
+#define FPS 60
+// Still often enough to catch a quick key tap and keep the music fed
+#define IDLE_FPS 20
+// Once the camera is this close to where it's going (in pixels) it jumps
+// the rest of the way, rather than creeping forever
+#define CAMERA_SETTLE 0.5
+
+#if defined(PLATFORM_WEB)
+void doEverything();
+#endif
+
+struct framePacer {
+    bool idle = false;
+    long long frames = 0;
+    long long idleFrames = 0;
+
+    // Called once a frame, after it's drawn, with whether the next can idle
+    void setIdle(bool nowIdle) {
+        frames++;
+        idleFrames += idle;
+        if (nowIdle == idle) {
+            return;
+        }
+        idle = nowIdle;
+#if defined(PLATFORM_WEB)
+        // emscripten_set_main_loop_timing only takes whole milliseconds, and
+        // a 60th of a second isn't one, so start the loop again at the new
+        // rate, timed exactly as main's was. The old loop stops once this
+        // frame returns.
+        emscripten_cancel_main_loop();
+        emscripten_set_main_loop(doEverything, idle ? IDLE_FPS : FPS, 0);
+#else
+        SetTargetFPS(idle ? IDLE_FPS : FPS);
+#endif
+    }
+};
+
+framePacer pacing;
+
 struct mainData {
     int argc;
     char** argv;
-    vector<string> map;
-    list<spider> spiders;
+    levelMap map;
+    // Walls never move during a level, so this is built once per level
+    bitboard walls;
+    pmr::list<spider> spiders;
+    spiderZones zones;
     int mapWidth = 0;
     int tickCount = 0;
     bool pause = false;
@@ -469,13 +1029,25 @@ struct mainData {
     Texture2D dirtHorizontal;
     Texture2D yerb;
     int totalApples = 0;
+    int nextSpiderId = 0;
+    rewindBuffer history;
     Music slugSong;
     bool restart = false;
+    bool ticked = false;
+
+    // The level's containers all draw from memory. Lists and vectors that
+    // get spliced or swapped with each other must share it.
+    mainData(pmr::memory_resource* memory = pmr::get_default_resource()) : map(memory), walls(memory),
+        spiders(memory), zones(memory), s(memory), history(memory) {}
 
     char& at(V2 v) {
         return map[v.y][v.x];
     }
 
+    bool ok(V2 v) {
+        return v.y >= 0 && v.y < map.size() && v.x >= 0 && v.x < map[v.y].size();
+    }
+
     // update rate for game logic is 60fps/tickRate()
     int tickRate() {
         if (pause) { return INT_MAX; }
@@ -494,6 +1066,22 @@ struct mainData {
         PlayMusicStream(slugSong);
     }
 
+    // Textures, the canvas and audio live outside levelMemory, so they have
+    // to be given back explicitly before the level goes away
+    void unloadAssets() {
+        StopMusicStream(slugSong);
+        UnloadMusicStream(slugSong);
+        UnloadTexture(dirt);
+        UnloadTexture(dirtHorizontal);
+        UnloadTexture(yerb);
+        UnloadRenderTexture(canvas);
+        s.unloadTextures();
+        for (spider& enemy : spiders) {
+            enemy.unloadTextures();
+        }
+        history.unloadTextures();
+    }
+
     void readLevel(string levelName) {
         map.clear();
         ifstream level(levelName);
@@ -501,9 +1089,9 @@ struct mainData {
             cerr << "Couldn't open " << levelName << endl;
             exit(EXIT_FAILURE);
         }
-        string line;
+        pmr::string line;
         V2 newSnakeHead;
-        list<V2> newSpiders;
+        pmr::list<V2> newSpiders;
         while (getline(level, line)) {
             mapWidth = max((int)line.size(), mapWidth);
             for (int i = 0; i < line.size(); i++) {
@@ -523,15 +1111,18 @@ struct mainData {
         canvas = LoadRenderTexture(mapWidth * GRID, map.size() * GRID);
         moveCameraX = mapWidth * GRID > WIDTH;
         moveCameraY = map.size() * GRID > HEIGHT;
-        s = snake(newSnakeHead, map);
+        walls.fromMap(map, WALL);
+        s = snake(newSnakeHead, map, walls);
         for (V2& pos : newSpiders) {
-            spiders.push_back(spider(pos, map));
+            spiders.push_back(spider(pos, map, walls));
+            spiders.back().id = nextSpiderId++;
         }
+        buildZones();
     }
 
-    void generateIsland(V2 start, int size, list<V2>& newSpiders) {
-        list<V2> fringe;
-        set<int> thisIsland;
+    void generateIsland(V2 start, int size, pmr::list<V2>& newSpiders) {
+        pmr::list<V2> fringe;
+        pmr::set<int> thisIsland;
         fringe.push_back(start);
         for (int i = 0; i < size; i++) {
             int select = GetRandomValue(0, fringe.size() - 1);
@@ -585,9 +1176,9 @@ struct mainData {
 
     void generateLevel() {
         mapWidth = 100;
-        map = vector<string>(100, string(100, EMPTY));
+        map = levelMap(100, pmr::string(100, EMPTY));
         V2 newSnakeHead;
-        list<V2> newSpiders;
+        pmr::list<V2> newSpiders;
 
         int numIslands = GetRandomValue(20, 35);
         for (int i = 0; i < numIslands; i++) {
@@ -608,16 +1199,82 @@ struct mainData {
         }
         canvas = LoadRenderTexture(mapWidth * GRID, map.size() * GRID);
         moveCameraX = moveCameraY = true;
-        s = snake(newSnakeHead, map);
+        walls.fromMap(map, WALL);
+        s = snake(newSnakeHead, map, walls);
         for (V2& pos : newSpiders) {
             if (at(pos) == EMPTY) {
                 for (V2 adj : {V2(1, 0), V2(-1, 0), V2(0, 1), V2(0, -1)}) {
                     if (at(pos + adj) == WALL) {
-                        spiders.push_back(spider(pos, map));
+                        spiders.push_back(spider(pos, map, walls));
+                        spiders.back().id = nextSpiderId++;
+                    }
+                }
+            }
+        }
+        buildZones();
+    }
+
+    // Give every spider its zone, spiders with the same reach sharing one,
+    // then count the snake that's already on the map
+    void buildZones() {
+        pmr::memory_resource* memory = map.get_allocator().resource();
+        auto layout = allocate_shared<zoneLayout>(pmr::polymorphic_allocator<zoneLayout>(memory), memory);
+        layout->width = mapWidth;
+        pmr::list<bitboard> reaches;
+        for (spider& enemy : spiders) {
+            bitboard reach;
+            enemy.findReach(reach, mapWidth);
+            enemy.zone = 0;
+            for (bitboard& other : reaches) {
+                if (other.bits == reach.bits) {
+                    break;
+                }
+                enemy.zone++;
+            }
+            if (enemy.zone == reaches.size()) {
+                reaches.push_back(move(reach));
+            }
+        }
+        layout->count = reaches.size();
+
+        // Count each tile's zones, then lay them out end to end
+        int tiles = mapWidth * map.size();
+        layout->firstZone.assign(tiles + 1, 0);
+        for (bitboard& reach : reaches) {
+            for (int row = 0; row < reach.height; row++) {
+                for (int w = 0; w < reach.words; w++) {
+                    for (uint64_t b = reach.row(row)[w]; b; b &= b - 1) {
+                        layout->firstZone[row * mapWidth + w * 64 + __builtin_ctzll(b) + 1]++;
                     }
                 }
             }
         }
+        for (int i = 0; i < tiles; i++) {
+            layout->firstZone[i + 1] += layout->firstZone[i];
+        }
+        layout->zoneList.resize(layout->firstZone[tiles]);
+        pmr::vector<int> filled(layout->firstZone.begin(), layout->firstZone.end() - 1);
+        int zone = 0;
+        for (bitboard& reach : reaches) {
+            for (int row = 0; row < reach.height; row++) {
+                for (int w = 0; w < reach.words; w++) {
+                    for (uint64_t b = reach.row(row)[w]; b; b &= b - 1) {
+                        layout->zoneList[filled[row * mapWidth + w * 64 + __builtin_ctzll(b)]++] = zone;
+                    }
+                }
+            }
+            zone++;
+        }
+
+        zones.layout = layout;
+        zones.snakeTiles.assign(layout->count, 0);
+        for (int row = 0; row < map.size(); row++) {
+            for (int col = 0; col < map[row].size(); col++) {
+                if (map[row][col] == SNAKE) {
+                    zones.changed(V2(col, row), EMPTY, SNAKE);
+                }
+            }
+        }
     }
 
 
@@ -637,7 +1294,7 @@ struct mainData {
                     int openAdjCount = 0;
                     V2 sourceTile(1, 1);
                     for (V2 adj : {V2(-1, 0), V2(1, 0), V2(0, -1), V2(0, 1)}) {
-                        if (s.ok(pos + adj) && (at(pos + adj) == EMPTY || at(pos + adj) == SNAKE || at(pos + adj) == APPLE || at(pos + adj) == ENEMY)) {
+                        if (ok(pos + adj) && (at(pos + adj) == EMPTY || at(pos + adj) == SNAKE || at(pos + adj) == APPLE || at(pos + adj) == ENEMY)) {
                             sourceTile = sourceTile + adj;
                             openAdjCount++;
                         }
@@ -690,48 +1347,186 @@ struct mainData {
         return 4.0 / (1 + exp(-0.33 * s.snakeSize));
     }
 
+    void undoCrossings(int crossings, tileChanges& moveMapBefore) {
+        if (crossings == 0) {
+            return;
+        }
+        s.restoreMoveMap(map, moveMapBefore);
+        if (crossings % 2 == 1) {
+            s.c.reverse();
+        }
+        s.moveQueue.clear();
+    }
+
+    // Take back up to count ticks, and any crossing made since the last one
+    void rewind(int count) {
+        undoCrossings(history.crossings, history.moveMapBefore);
+        history.crossings = 0;
+        for (int i = 0; i < count && !history.ticks.empty(); i++) {
+            tickUndo& undo = history.ticks.back();
+            s.undoTick(map, zones, undo.snake);
+            // Caught spiders go back first, so the indices line up again
+            for (int index : undo.caughtAt) {
+                auto at = spiders.begin();
+                advance(at, index);
+                spiders.splice(at, undo.caught, undo.caught.begin());
+            }
+            for (auto& move : undo.spiderMoves) {
+                auto enemy = spiders.begin();
+                advance(enemy, move.first);
+                enemy->segments.front() = move.second.first;
+                enemy->segments.back() = move.second.second;
+            }
+            s.snakeSize = undo.snakeSize;
+            totalApples = undo.totalApples;
+            undoCrossings(undo.crossings, undo.moveMapBefore);
+            history.ticks.pop_back();
+        }
+        render(false);
+        // Not a tick as such, but spectators need to hear about it
+        ticked = true;
+    }
+
+    bool playing() {
+        return s.snakeSize != totalApples + 1 && s.snakeSize >= 1;
+    }
+
+    // Nothing but the odd apple bob will change until a key is pressed
+    bool still() {
+        Vector2 target = targetCamera();
+        return (pause || !playing()) && camera.x == target.x && camera.y == target.y;
+    }
+
+    // One tick of game logic. undo, if given, gets what's needed to rewind it.
+    void step(tickUndo* undo) {
+        auto spider = spiders.begin();
+        for (int index = 0; spider != spiders.end(); index++) {
+            // Asleep: there's no snake it could find or be touching
+            if (!zones.occupied(spider->zone)) {
+                spider++;
+                continue;
+            }
+            segment head = spider->segments.front();
+            segment tail = spider->segments.back();
+            if (spider->doTick(map)) {
+                s.snakeSize -= 3;
+                totalApples -= 3;
+                if (undo) {
+                    // Kept rather than erased, in case we rewind
+                    auto caught = spider++;
+                    undo->caught.splice(undo->caught.end(), spiders, caught);
+                    undo->caughtAt.push_back(index);
+                }
+                else {
+                    spider->unloadTextures();
+                    spider = spiders.erase(spider);
+                }
+            }
+            else {
+                if (undo && (!sameSegment(head, spider->segments.front()) || !sameSegment(tail, spider->segments.back()))) {
+                    undo->spiderMoves.push_back({index, {head, tail}});
+                }
+                spider++;
+            }
+        }
+        s.doTick(map, zones, undo ? &undo->snake : nullptr);
+    }
+
+    // Set off for the opposite wall, if there's one in reach
+    bool cross() {
+        if (s.cross(map, walls, history.crossings == 0 ? &history.moveMapBefore : nullptr)) {
+            history.crossings++;
+            return true;
+        }
+        return false;
+    }
+
+    // Become a silent copy of game's simulation, leaving assets alone. The
+    // copied spiders get no texture, so unloading theirs is a no-op. Their
+    // move maps and the zone layout are only borrowed: they live in the
+    // game's memory, which only the game's own thread may hand back, and
+    // the next copy replaces them before a restart could leave them dangling.
+    void copyStateFrom(mainData& game) {
+        map = game.map;
+        walls = game.walls;
+        mapWidth = game.mapWidth;
+        totalApples = game.totalApples;
+        *s.moveMap = *game.s.moveMap;
+        s.segments = game.s.segments;
+        s.moveQueue = game.s.moveQueue;
+        s.c = game.s.c;
+        s.snakeSize = game.s.snakeSize;
+        s.quiet = true;
+        spiders = game.spiders;
+        zones.layout = shared_ptr<const zoneLayout>(shared_ptr<const zoneLayout>(), game.zones.layout.get());
+        zones.snakeTiles = game.zones.snakeTiles;
+        for (spider& enemy : spiders) {
+            enemy.quiet = true;
+            enemy.tex = {0};
+            enemy.moveMap = shared_ptr<levelMap>(shared_ptr<levelMap>(), enemy.moveMap.get());
+        }
+    }
+
     void mainLoop() {
         BeginDrawing();
+        ticked = false;
         //DO THE FOLLOWING AT TICK RATE
         if (tickCount % tickRate() == 0) {
-            if (s.snakeSize != totalApples + 1 && s.snakeSize >= 1) {
-                auto spider = spiders.begin();
-                while (spider != spiders.end()) {
-                    if (spider->doTick(map)) {
-                        s.snakeSize -= 3;
-                        totalApples -= 3;
-                        spider = spiders.erase(spider);
-                    }
-                    else {
-                        spider++;
-                    }
-                }
-                s.doTick(map);
+            if (playing()) {
+                step(&history.beginTick(s.snakeSize, totalApples));
+                ticked = true;
             }
             render(false);
         }
         //DO THE FOLLOWING AT 60FPS
         UpdateMusicStream(slugSong);
-        s.handleInput(map);
+        if (IsKeyPressed(KEY_SPACE)) {
+            cross();
+        }
+        if (IsKeyPressed(KEY_Z)) {
+            rewind(REWIND_STEP);
+        }
         // debug: pause the game if we press backspace
         if (IsKeyPressed(KEY_BACKSPACE)) {
             // toggle pause
             pause = !pause;
             render(true);
         }
-        //Update camera position to keep snake head near center of screen
-        Vector2 targetCamera = camera;
+        present();
+        if (IsKeyPressed(KEY_R)) {
+            restart = true;
+        }
+        EndDrawing();
+        tickCount++;
+    }
+
+    // Where the camera wants to be: snake head near center of screen
+    Vector2 targetCamera() {
+        Vector2 target = camera;
         if (moveCameraX) {
-            targetCamera.x = min(mapWidth * GRID - WIDTH, max(0, int((s.head().x + 0.5) * GRID - WIDTH / 2)));
+            target.x = min(mapWidth * GRID - WIDTH, max(0, int((s.head().x + 0.5) * GRID - WIDTH / 2)));
         }
         if (moveCameraY) {
-            targetCamera.y = min((int)map.size() * GRID - HEIGHT, max(0, int((s.head().y + 0.5) * GRID - HEIGHT / 2)));
+            target.y = min((int)map.size() * GRID - HEIGHT, max(0, int((s.head().y + 0.5) * GRID - HEIGHT / 2)));
         }
+        return target;
+    }
+
+    // Draw the canvas through the camera, plus the overlays. Shared with
+    // spectators, which have no simulation of their own.
+    void present() {
+        //Update camera position to keep snake head near center of screen
+        Vector2 target = targetCamera();
         if (tickCount == 0) {
-            camera = targetCamera;
+            camera = target;
+        }
+        Vector2 cameraMove = Vector2Subtract(target, camera);
+        if (fabs(cameraMove.x) < CAMERA_SETTLE && fabs(cameraMove.y) < CAMERA_SETTLE) {
+            camera = target;
+        }
+        else {
+            camera = Vector2Add(camera, Vector2Scale(cameraMove, 0.02));
         }
-        Vector2 cameraMove = Vector2Subtract(targetCamera, camera);
-        camera = Vector2Add(camera, Vector2Scale(cameraMove, 0.02));
         ClearBackground(BLACK);
         Texture* t = &canvas.texture;
         Rectangle source = {0, 0, (float)t->width, -1 * (float)t->height};
@@ -747,69 +1542,898 @@ struct mainData {
             DrawRectangle(0, 0, WIDTH, HEIGHT, (Color){0, 0, 0, 100});
             DrawText("Ow, oof, my grades!", GRID, GRID, 1.3 * GRID, WHITE);
             DrawText("Press R to restart.", GRID, GRID + 120, 1.3 * GRID, RED);
-        }
-        if (IsKeyPressed(KEY_R)) {
-            restart = true;
+            DrawText("Press Z to rewind.", GRID, GRID + 160, 1.3 * GRID, RED);
         }
         // draw GPA (score) meter
         DrawText(TextFormat("GPA: %02.02f", logisticGPA()), WIDTH - 150, 10, GRID, WHITE);
-        EndDrawing();
-        tickCount++;
     }
 
 };
 
 
-mainData everything;
+// Lookahead bot. The only choice the snake ever makes is when to cross, so
+// every tick it plays out futures that start by crossing and futures that
+// start by sticking to the wall, on throwaway copies of the game, and goes
+// with whichever did better on average.
+#define BOT_ROLLOUTS 32
+#define BOT_HORIZON 24
+// Rollouts cross on about one tick in this many
+#define BOT_CROSS_ODDS 8
+#define BOT_THREADS 4
+// Frames attract mode lingers on a finished game before starting another
+#define BOT_ATTRACT_PAUSE 180
+
+struct lookaheadBot {
+    bool enabled = false;
+    unsigned int seed = 1;
+    int idleFrames = 0;
+    // One per thread, kept between decisions so their buffers get reused
+    vector<unique_ptr<mainData>> worlds;
+    long long rolloutsRun = 0;
+    double rolloutSeconds = 0;
+
+    // Helper threads, started with the first decision and kept until we
+    // go away. Each new generation is a job for all of them to run once.
+    vector<thread> helpers;
+    mutex poolLock;
+    condition_variable wake;
+    condition_variable finished;
+    function<void(int)> job;
+    int generation = 0;
+    int busy = 0;
+    bool stopping = false;
+
+    ~lookaheadBot() {
+        {
+            lock_guard<mutex> lock(poolLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (thread& helper : helpers) {
+            helper.join();
+        }
+    }
+
+    void helperLoop(int index, int seen) {
+        unique_lock<mutex> lock(poolLock);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            lock.unlock();
+            job(index);
+            lock.lock();
+            if (--busy == 0) {
+                finished.notify_one();
+            }
+        }
+    }
+
+    // Run work(0) up to work(threads - 1) at once, and wait for them all
+    void runOnAll(function<void(int)> work, int threads) {
+        while (helpers.size() + 1 < threads) {
+            helpers.emplace_back(&lookaheadBot::helperLoop, this, helpers.size() + 1, generation);
+        }
+        {
+            lock_guard<mutex> lock(poolLock);
+            job = work;
+            busy = helpers.size();
+            generation++;
+        }
+        wake.notify_all();
+        work(0);
+        unique_lock<mutex> lock(poolLock);
+        finished.wait(lock, [&] { return busy == 0; });
+    }
+
+    // Apples eaten less apples lost to spiders, but losing or winning
+    // outweighs any amount of those
+    int rollout(mainData& world, mainData& game, bool crossNow, unsigned int rolloutSeed) {
+        world.copyStateFrom(game);
+        mt19937 rng(rolloutSeed);
+        int startSize = world.s.snakeSize;
+        if (crossNow) {
+            world.s.cross(world.map, world.walls);
+        }
+        for (int t = 0; t < BOT_HORIZON && world.playing(); t++) {
+            if (t > 0 && rng() % BOT_CROSS_ODDS == 0) {
+                world.s.cross(world.map, world.walls);
+            }
+            world.step(nullptr);
+        }
+        int score = world.s.snakeSize - startSize;
+        if (world.s.snakeSize < 1) {
+            score -= 100;
+        }
+        else if (!world.playing()) {
+            score += 100;
+        }
+        return score;
+    }
+
+    bool shouldCross(mainData& game) {
+#if defined(PLATFORM_WEB)
+        int threads = 1;
+#else
+        int threads = BOT_THREADS;
+#endif
+        while (worlds.size() < threads) {
+            worlds.push_back(make_unique<mainData>());
+        }
+        // Nothing to decide if there's nowhere to cross to
+        worlds[0]->copyStateFrom(game);
+        if (!worlds[0]->s.cross(worlds[0]->map, worlds[0]->walls)) {
+            return false;
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<long long> totals(2 * threads, 0);
+        // Both choices see the same seeds, so luck in the later crossings
+        // doesn't decide between them
+        auto work = [&](int thread) {
+            for (int i = thread; i < 2 * BOT_ROLLOUTS; i += threads) {
+                bool crossNow = i % 2 == 1;
+                totals[2 * thread + crossNow] += rollout(*worlds[thread], game, crossNow, seed + i / 2);
+            }
+        };
+        runOnAll(work, threads);
+        seed += BOT_ROLLOUTS;
+        rolloutsRun += 2 * BOT_ROLLOUTS;
+        rolloutSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        long long stay = 0, cross = 0;
+        for (int t = 0; t < threads; t++) {
+            stay += totals[2 * t];
+            cross += totals[2 * t + 1];
+        }
+        return cross > stay;
+    }
+
+    // Attract mode: play, and start a new game a little while after one ends
+    void drive(mainData& game) {
+        if (!game.playing()) {
+            if (++idleFrames > BOT_ATTRACT_PAUSE) {
+                game.restart = true;
+                idleFrames = 0;
+            }
+            return;
+        }
+        idleFrames = 0;
+        if (!game.pause && game.tickCount % game.tickRate() == 0 && shouldCross(game)) {
+            game.cross();
+        }
+    }
+};
+
+
+// Snapshot stream for spectators. Every tick becomes one frame: a varint
+// length, a flags byte, then whichever sections the flags announce. Deltas
+// are taken against a replica of what the spectator already has, so an
+// ordinary tick costs a few bytes. A rewind resends the whole snake, and the
+// spiders if any come back, plus the tiles it changed. Keyframes resend the
+// whole level: on a new level, whenever a spectator (re)connects, and every
+// so often anyway.
+// There is one spectator at a time; when they leave, the next one to open
+// the FIFO takes over.
+#define SNAP_KEYFRAME 1
+#define SNAP_SNAKE 2
+#define SNAP_SPIDERS 4
+#define SNAP_SCORE 8
+#define SNAP_TILES 16
+#define SNAP_WHOLE_SNAKE 32
+#define SNAP_WHOLE_SPIDERS 64
+#define KEYFRAME_INTERVAL 600
+
+void putVarint(string& out, unsigned int v) {
+    while (v >= 0x80) {
+        out.push_back((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((char)v);
+}
+
+void putSigned(string& out, int v) {
+    putVarint(out, ((unsigned int)v << 1) ^ (unsigned int)(v >> 31));
+}
+
+struct snapshotCursor {
+    const string& data;
+    size_t pos;
+    size_t end;
+    bool overrun = false;
+
+    snapshotCursor(const string& newData, size_t newPos, size_t newEnd) : data(newData), pos(newPos), end(newEnd) {}
+
+    unsigned char byte() {
+        if (pos >= end) {
+            overrun = true;
+            return 0;
+        }
+        return data[pos++];
+    }
+
+    unsigned int varint() {
+        unsigned int v = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            unsigned char b = byte();
+            v |= (unsigned int)(b & 0x7f) << shift;
+            if (!(b & 0x80)) {
+                break;
+            }
+        }
+        return v;
+    }
+
+    int signedVarint() {
+        unsigned int v = varint();
+        return (int)(v >> 1) ^ -(int)(v & 1);
+    }
+};
+
+// What a spectator knows about the game: enough to draw it, nothing more
+struct snapshotState {
+    compass c;
+    int mapWidth = 0;
+    vector<string> map;
+    list<segment> snake;
+    vector<V2> spiders;
+    int snakeSize = 0;
+    int totalApples = 0;
+
+    bool ok(V2 v) {
+        return v.y >= 0 && v.y < map.size() && v.x >= 0 && v.x < map[v.y].size();
+    }
+
+    // Same map bookkeeping as snake::doTick, so the spectator never needs
+    // to be told about the tiles the snake paints
+    void push(segment seg) {
+        snake.push_front(seg);
+        if (ok(seg.pos)) {
+            map[seg.pos.y][seg.pos.x] = SNAKE;
+        }
+    }
+
+    void pop() {
+        if (snake.empty()) {
+            return;
+        }
+        V2 tail = snake.back().pos;
+        if (ok(tail)) {
+            map[tail.y][tail.x] = EMPTY;
+        }
+        snake.pop_back();
+    }
+
+    // forward and down as cardinal indices, then which way we're going round
+    unsigned char pack(segment& seg) {
+        return c.cardinalIndex(seg.forward) | c.cardinalIndex(seg.down) << 2 | (seg.clockwise > 0 ? 16 : 0);
+    }
+
+    segment unpack(V2 pos, unsigned char bits) {
+        return segment(pos, c.cardinal[bits & 3], c.cardinal[(bits >> 2) & 3], bits & 16 ? 1 : -1);
+    }
+
+    void readSnake(snapshotCursor& in) {
+        snake.clear();
+        for (unsigned int i = in.varint(); i > 0 && !in.overrun; i--) {
+            int x = in.varint();
+            int y = in.varint();
+            V2 pos(x, y);
+            snake.push_back(unpack(pos, in.byte()));
+        }
+    }
+
+    void readSpiders(snapshotCursor& in) {
+        spiders.clear();
+        for (unsigned int i = in.varint(); i > 0 && !in.overrun; i--) {
+            int x = in.varint();
+            int y = in.varint();
+            V2 pos(x, y);
+            spiders.push_back(pos);
+        }
+    }
+
+    void apply(snapshotCursor& in) {
+        unsigned char flags = in.byte();
+        if (flags & SNAP_KEYFRAME) {
+            mapWidth = in.varint();
+            map.assign(min(in.varint(), (unsigned int)(in.end - in.pos)), string());
+            for (string& row : map) {
+                unsigned int length = min(in.varint(), (unsigned int)(in.end - in.pos));
+                row.assign(in.data, in.pos, length);
+                in.pos += length;
+            }
+            readSnake(in);
+            snakeSize = in.signedVarint();
+            totalApples = in.signedVarint();
+            readSpiders(in);
+        }
+        // The map's tiles come separately, under SNAP_TILES
+        if (flags & SNAP_WHOLE_SNAKE) {
+            readSnake(in);
+        }
+        if (flags & SNAP_SNAKE && !snake.empty()) {
+            unsigned char bits = in.byte();
+            int pops = bits >> 6;
+            if (pops == 3) {
+                pops = in.varint();
+            }
+            if (bits & 32) {
+                push(unpack(snake.front().pos + c.cardinal[bits & 3], bits));
+            }
+            for (int i = 0; i < pops; i++) {
+                pop();
+            }
+        }
+        if (flags & SNAP_WHOLE_SPIDERS) {
+            readSpiders(in);
+        }
+        if (flags & SNAP_SPIDERS) {
+            vector<bool> removed(spiders.size());
+            for (unsigned int i = in.varint(); i > 0 && !in.overrun; i--) {
+                unsigned int entry = in.varint();
+                unsigned int index = entry >> 1;
+                if (index >= spiders.size()) {
+                    continue;
+                }
+                if (entry & 1) {
+                    removed[index] = true;
+                }
+                else {
+                    int dx = in.signedVarint();
+                    int dy = in.signedVarint();
+                    spiders[index] = spiders[index] + V2(dx, dy);
+                }
+            }
+            for (int i = spiders.size() - 1; i >= 0; i--) {
+                if (removed[i]) {
+                    spiders.erase(spiders.begin() + i);
+                }
+            }
+        }
+        if (flags & SNAP_SCORE) {
+            snakeSize += in.signedVarint();
+            totalApples += in.signedVarint();
+        }
+        if (flags & SNAP_TILES && mapWidth > 0) {
+            unsigned int index = 0;
+            for (unsigned int i = in.varint(); i > 0 && !in.overrun; i--) {
+                index += in.varint();
+                V2 pos(index % mapWidth, index / mapWidth);
+                char tile = in.byte();
+                if (ok(pos)) {
+                    map[pos.y][pos.x] = tile;
+                }
+            }
+        }
+    }
+};
+
+struct snapshotWriter {
+    snapshotState replica;
+    vector<int> spiderIds;
+    bool valid = false;
+    int sinceKeyframe = 0;
+    int fd = -1;
+    string path;
+    // The spectator left a FIFO, so wait for the next one to open it
+    bool reopen = false;
+
+    void putSnake(mainData& game, string& out) {
+        putVarint(out, game.s.segments.size());
+        for (segment& seg : game.s.segments) {
+            putVarint(out, seg.pos.x);
+            putVarint(out, seg.pos.y);
+            out.push_back(replica.pack(seg));
+        }
+    }
+
+    void putSpiders(mainData& game, string& out) {
+        putVarint(out, game.spiders.size());
+        for (spider& enemy : game.spiders) {
+            putVarint(out, enemy.segments.begin()->pos.x);
+            putVarint(out, enemy.segments.begin()->pos.y);
+        }
+    }
+
+    void encodeKeyframe(mainData& game, string& body) {
+        body.push_back(SNAP_KEYFRAME);
+        putVarint(body, game.mapWidth);
+        putVarint(body, game.map.size());
+        for (pmr::string& row : game.map) {
+            putVarint(body, row.size());
+            body.append(row.begin(), row.end());
+        }
+        putSnake(game, body);
+        putSigned(body, game.s.snakeSize);
+        putSigned(body, game.totalApples);
+        putSpiders(game, body);
+        spiderIds.clear();
+        for (spider& enemy : game.spiders) {
+            spiderIds.push_back(enemy.id);
+        }
+        snapshotCursor in(body, 0, body.size());
+        replica.apply(in);
+        valid = true;
+        sinceKeyframe = 0;
+    }
+
+    // Returns false if this tick can't be told as a delta, e.g. a new level
+    bool encodeDelta(mainData& game, string& body) {
+        pmr::list<segment>& segments = game.s.segments;
+        if (game.map.size() != replica.map.size() || game.mapWidth != replica.mapWidth) {
+            return false;
+        }
+        unsigned char flags = 0;
+        string sections;
+
+        // Normally the snake has moved: maybe a new head, maybe some tail
+        // gone, the rest as it was. A rewind can leave it any shape at all,
+        // and being caught can leave none of it.
+        bool moved = !segments.empty() && !replica.snake.empty();
+        bool pushed = moved && !sameSegment(segments.front(), replica.snake.front());
+        int pops = (int)replica.snake.size() + pushed - (int)segments.size();
+        moved = moved && pops >= 0
+            && (!pushed || segments.front().pos == replica.snake.front().pos + segments.front().forward);
+        if (moved) {
+            auto mirrored = replica.snake.begin();
+            for (auto seg = next(segments.begin(), pushed); seg != segments.end(); seg++, mirrored++) {
+                if (!sameSegment(*seg, *mirrored)) {
+                    moved = false;
+                    break;
+                }
+            }
+        }
+        if (!moved) {
+            flags |= SNAP_WHOLE_SNAKE;
+            putSnake(game, sections);
+        }
+        else if (pushed || pops > 0) {
+            flags |= SNAP_SNAKE;
+            sections.push_back(replica.pack(segments.front()) | (pushed ? 32 : 0) | min(pops, 3) << 6);
+            if (pops >= 3) {
+                putVarint(sections, pops);
+            }
+        }
+
+        // Spiders are only ever removed mid-level, except by rewinding, so
+        // walking both lists in step is nearly always enough to pair them up
+        string spiderSection;
+        int changed = 0;
+        auto enemy = game.spiders.begin();
+        for (int i = 0; i < spiderIds.size(); i++) {
+            if (enemy != game.spiders.end() && enemy->id == spiderIds[i]) {
+                V2 head = enemy->segments.begin()->pos;
+                if (head != replica.spiders[i]) {
+                    putVarint(spiderSection, i << 1);
+                    putSigned(spiderSection, head.x - replica.spiders[i].x);
+                    putSigned(spiderSection, head.y - replica.spiders[i].y);
+                    changed++;
+                }
+                enemy++;
+            }
+            else {
+                putVarint(spiderSection, i << 1 | 1);
+                changed++;
+            }
+        }
+        if (enemy != game.spiders.end()) {
+            // Some came back
+            flags |= SNAP_WHOLE_SPIDERS;
+            putSpiders(game, sections);
+        }
+        else if (changed > 0) {
+            flags |= SNAP_SPIDERS;
+            putVarint(sections, changed);
+            sections += spiderSection;
+        }
+
+        if (game.s.snakeSize != replica.snakeSize || game.totalApples != replica.totalApples) {
+            flags |= SNAP_SCORE;
+            putSigned(sections, game.s.snakeSize - replica.snakeSize);
+            putSigned(sections, game.totalApples - replica.totalApples);
+        }
+
+        body.push_back(flags);
+        body += sections;
+        snapshotCursor in(body, 0, body.size());
+        replica.apply(in);
+
+        auto seg = segments.begin();
+        for (segment& mirrored : replica.snake) {
+            if (seg == segments.end() || !sameSegment(*seg, mirrored)) {
+                return false;
+            }
+            seg++;
+        }
+        if (seg != segments.end()) {
+            return false;
+        }
+        spiderIds.clear();
+        for (spider& enemy : game.spiders) {
+            spiderIds.push_back(enemy.id);
+        }
+
+        // Whatever the spectator couldn't work out from the snake itself
+        string tiles;
+        int tileCount = 0;
+        int lastIndex = 0;
+        for (int row = 0; row < game.map.size(); row++) {
+            if (game.map[row].size() != replica.map[row].size()) {
+                return false;
+            }
+            for (int col = 0; col < game.map[row].size(); col++) {
+                if (game.map[row][col] != replica.map[row][col]) {
+                    int index = row * game.mapWidth + col;
+                    putVarint(tiles, index - lastIndex);
+                    tiles.push_back(game.map[row][col]);
+                    replica.map[row][col] = game.map[row][col];
+                    lastIndex = index;
+                    tileCount++;
+                }
+            }
+        }
+        if (tileCount > 0) {
+            body[0] |= SNAP_TILES;
+            putVarint(body, tileCount);
+            body += tiles;
+        }
+        return true;
+    }
+
+    // One length-prefixed frame describing this tick
+    string encode(mainData& game) {
+        string body;
+        if (!valid || ++sinceKeyframe >= KEYFRAME_INTERVAL || !encodeDelta(game, body)) {
+            body.clear();
+            encodeKeyframe(game, body);
+        }
+        string frame;
+        putVarint(frame, body.size());
+        return frame + body;
+    }
+
+#if defined(SNAPSHOT_STREAMS)
+    // Opening a FIFO blocks until a spectator opens the other end
+    bool openStream(const char* newPath) {
+        signal(SIGPIPE, SIG_IGN);
+        path = newPath;
+        fd = open(newPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            cerr << "Couldn't open " << newPath << " for streaming\n";
+            return false;
+        }
+        return true;
+    }
+
+    // Without O_NONBLOCK this would stall the game until someone came
+    // along; with it, opening fails straight away while nobody's reading
+    void reconnect() {
+        if (!reopen) {
+            return;
+        }
+        fd = open(path.c_str(), O_WRONLY | O_NONBLOCK);
+        if (fd < 0) {
+            return;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        reopen = false;
+        // They know nothing yet, so start them off with a keyframe
+        valid = false;
+        cout << "A spectator joined on " << path << "\n";
+    }
+
+    void record(mainData& game) {
+        string frame = encode(game);
+        size_t sent = 0;
+        while (sent < frame.size()) {
+            ssize_t n = write(fd, frame.data() + sent, frame.size() - sent);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n <= 0) {
+                struct stat info;
+                reopen = fstat(fd, &info) == 0 && S_ISFIFO(info.st_mode);
+                if (reopen) {
+                    cerr << "Spectator went away, waiting for another on " << path << "\n";
+                }
+                else {
+                    cerr << "Spectator went away, no longer streaming\n";
+                }
+                close(fd);
+                fd = -1;
+                return;
+            }
+            sent += n;
+        }
+    }
+#endif
+};
+
+struct snapshotReader {
+    snapshotState state;
+    string pending;
+    bool synced = false;
+    bool canvasLoaded = false;
+    int fd = -1;
+
+    // Returns true if at least one whole tick came in. Deltas that arrive
+    // before the first keyframe can't be applied, so they're dropped.
+    bool feed(const char* data, size_t size) {
+        pending.append(data, size);
+        bool applied = false;
+        size_t start = 0;
+        while (true) {
+            snapshotCursor header(pending, start, pending.size());
+            unsigned int length = header.varint();
+            if (header.overrun || pending.size() - header.pos < length) {
+                break;
+            }
+            snapshotCursor body(pending, header.pos, header.pos + length);
+            start = header.pos + length;
+            if (length > 0 && (synced || pending[body.pos] & SNAP_KEYFRAME)) {
+                state.apply(body);
+                synced = true;
+                applied = true;
+            }
+        }
+        pending.erase(0, start);
+        return applied;
+    }
+
+    // Copy what we know into the game so the usual render code can draw it
+    void show(mainData& game) {
+        if (!canvasLoaded || game.mapWidth != state.mapWidth || game.map.size() != state.map.size()) {
+            if (canvasLoaded) {
+                UnloadRenderTexture(game.canvas);
+            }
+            game.canvas = LoadRenderTexture(state.mapWidth * GRID, state.map.size() * GRID);
+            canvasLoaded = true;
+            game.mapWidth = state.mapWidth;
+            game.moveCameraX = state.mapWidth * GRID > WIDTH;
+            game.moveCameraY = state.map.size() * GRID > HEIGHT;
+            game.tickCount = 0;
+        }
+        game.map.assign(state.map.begin(), state.map.end());
+        game.s.segments.assign(state.snake.begin(), state.snake.end());
+        game.s.snakeSize = state.snakeSize;
+        game.totalApples = state.totalApples;
+        while (game.spiders.size() > state.spiders.size()) {
+            game.spiders.back().unloadTextures();
+            game.spiders.pop_back();
+        }
+        while (game.spiders.size() < state.spiders.size()) {
+            game.spiders.emplace_back();
+        }
+        auto enemy = game.spiders.begin();
+        for (V2& head : state.spiders) {
+            enemy->segments.assign(1, segment(head, V2(), V2(), -1));
+            enemy++;
+        }
+    }
+
+#if defined(SNAPSHOT_STREAMS)
+    bool openStream(const char* path) {
+        fd = open(path, O_RDONLY | O_NONBLOCK);
+        if (fd < 0) {
+            cerr << "Couldn't open " << path << " to spectate\n";
+            return false;
+        }
+        return true;
+    }
+
+    bool poll(mainData& game) {
+        char chunk[4096];
+        ssize_t n;
+        bool applied = false;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            applied |= feed(chunk, n);
+        }
+        if (applied) {
+            show(game);
+        }
+        return applied;
+    }
+#endif
+};
+
+
+unique_ptr<mainData> everything;
+lookaheadBot autopilot;
+#if defined(SNAPSHOT_STREAMS)
+snapshotWriter broadcast;
+snapshotReader spectator;
+#endif
 void initEverything(int argc, char** argv) {
-    everything = mainData();
-    everything.initAssets();
-    everything.argc = argc;
-    everything.argv = argv;
+    if (everything) {
+        everything->unloadAssets();
+        everything.reset();
+    }
+    // Nothing from the old level is alive any more, so give its memory back
+    levelMemory.release();
+    everything = make_unique<mainData>(&levelMemory);
+    everything->initAssets();
+    everything->argc = argc;
+    everything->argv = argv;
     if (argc == 2) {
         if (argv[1] == string("random")) {
-            everything.generateLevel();
+            everything->generateLevel();
         }
         else {
-            everything.readLevel(argv[1]);
+            everything->readLevel(argv[1]);
         }
     }
     else {
-        everything.readLevel("resources/good.lvl");
+        everything->readLevel("resources/good.lvl");
     }
-    everything.playMusic();
+    everything->playMusic();
 }
 
 void doEverything() {
-    everything.mainLoop();
+    if (autopilot.enabled) {
+        autopilot.drive(*everything);
+    }
+    everything->mainLoop();
+    // Attract mode counts frames to know when to start the next game
+    pacing.setIdle(everything->still() && !autopilot.enabled);
+#if defined(SNAPSHOT_STREAMS)
+    broadcast.reconnect();
+    if (broadcast.fd >= 0 && (everything->ticked || !broadcast.valid)) {
+        broadcast.record(*everything);
+    }
+#endif
     // restart if we press R 
-    if (everything.restart) {
-        everything.restart = false;
-        int argc = everything.argc;
-        char** argv = everything.argv;
+    if (everything->restart) {
+        everything->restart = false;
+        int argc = everything->argc;
+        char** argv = everything->argv;
         initEverything(argc, argv);
+#if defined(SNAPSHOT_STREAMS)
+        broadcast.valid = false;
+#endif
     }
 }
 
+// Longest game rateLevels will play, in ticks
+#define RATE_TICK_LIMIT 3000
+
+// Let the bot play games as fast as they'll go and report how it did, as a
+// rough measure of how hard the level (or the level generator) is
+void rateLevels(int argc, char** argv, int games) {
+    double totalGPA = 0;
+    int wins = 0;
+    for (int g = 1; g <= games; g++) {
+        initEverything(argc, argv);
+        mainData& game = *everything;
+        StopMusicStream(game.slugSong);
+        game.s.quiet = true;
+        for (spider& enemy : game.spiders) {
+            enemy.quiet = true;
+        }
+        int ticks = 0;
+        while (game.playing() && ticks < RATE_TICK_LIMIT) {
+            // Nothing here rewinds, so nothing is recorded for it
+            if (autopilot.shouldCross(game)) {
+                game.s.cross(game.map, game.walls);
+            }
+            game.step(nullptr);
+            ticks++;
+        }
+        const char* result = game.s.snakeSize < 1 ? "lost" : game.playing() ? "timed out" : "won";
+        wins += !game.playing() && game.s.snakeSize >= 1;
+        totalGPA += game.logisticGPA();
+        cout << "Game " << g << ": " << result << " after " << ticks << " ticks, "
+             << game.s.snakeSize - 1 << " yerbs, GPA " << TextFormat("%.2f", game.logisticGPA()) << "\n";
+    }
+    cout << "Won " << wins << "/" << games << ", average GPA " << TextFormat("%.2f", totalGPA / games)
+         << ", " << (long long)(autopilot.rolloutsRun / max(autopilot.rolloutSeconds, 1e-9)) << " rollouts/s\n";
+}
+
+#if defined(SNAPSHOT_STREAMS)
+void initSpectator(const char* path) {
+    everything = make_unique<mainData>();
+    everything->initAssets();
+    everything->s.initTextures();
+    everything->playMusic();
+    if (!spectator.openStream(path)) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+void doSpectate() {
+    mainData& game = *everything;
+    BeginDrawing();
+    if (spectator.poll(game)) {
+        game.render(false);
+    }
+    UpdateMusicStream(game.slugSong);
+    if (spectator.synced) {
+        game.present();
+    }
+    else {
+        ClearBackground(BLACK);
+        DrawText("Waiting for a game to watch...", GRID, GRID, GRID, WHITE);
+    }
+    EndDrawing();
+    game.tickCount++;
+}
+#endif
+
 
 int main(int argc, char** argv) {
 
+    // Everything but the options, which is what initEverything looks at
+    static vector<char*> args;
+    char* spectatePath = nullptr;
+    int rateGames = 0;
+    for (int i = 0; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--bot") {
+            autopilot.enabled = true;
+        }
+        else if (arg == "--rate" && i + 1 < argc) {
+            rateGames = max(1, atoi(argv[++i]));
+        }
+#if defined(SNAPSHOT_STREAMS)
+        // snacman [level] --stream <path> sends every tick to <path>, which
+        // snacman --spectate <path> draws. <path> is usually a FIFO.
+        else if (arg == "--spectate" && i + 1 < argc) {
+            spectatePath = argv[++i];
+        }
+        else if (arg == "--stream" && i + 1 < argc) {
+            cout << "Waiting for a spectator on " << argv[i + 1] << "\n";
+            if (!broadcast.openStream(argv[++i])) {
+                exit(EXIT_FAILURE);
+            }
+        }
+#endif
+        else {
+            args.push_back(argv[i]);
+        }
+    }
+    argc = args.size();
+    argv = args.data();
     if (argc > 2) {
-        cerr << "Usage: " << argv[0] << "<level file>\n";
+        cerr << "Usage: " << argv[0] << " [<level file> | random] [--bot] [--rate <games>] [--stream <path>]\n";
+        cerr << "       " << argv[0] << " --spectate <path>\n";
         exit(EXIT_FAILURE);
     }
 
+    if (rateGames > 0) {
+        SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    }
     InitWindow(WIDTH, HEIGHT, "snacman");
     InitAudioDevice();
-    initEverything(argc, argv);
 
 #if defined(PLATFORM_WEB)
-    emscripten_set_main_loop(doEverything, 60, 1);
+    initEverything(argc, argv);
+    emscripten_set_main_loop(doEverything, FPS, 1);
 #else
-    SetTargetFPS(60);
-    while (!WindowShouldClose()) {
-        doEverything();
+    SetTargetFPS(FPS);
+    if (rateGames > 0) {
+        rateLevels(argc, argv, rateGames);
+    }
+    else if (spectatePath) {
+#if defined(SNAPSHOT_STREAMS)
+        initSpectator(spectatePath);
+        while (!WindowShouldClose()) {
+            doSpectate();
+        }
+#endif
+    }
+    else {
+        initEverything(argc, argv);
+        while (!WindowShouldClose()) {
+            doEverything();
 
+        }
+    }
+    if (rateGames == 0) {
+        cout << "Drew " << pacing.frames << " frames, " << pacing.idleFrames << " at the idle rate, about "
+             << pacing.idleFrames * (FPS / IDLE_FPS - 1) << " fewer than at full speed\n";
     }
 #endif
+    return EXIT_SUCCESS;
 }
@@ -0,0 +1,18 @@
+// What the tests share: all of snacman.cpp, with its main renamed out of the
+// way, and the keys they play with
+#pragma once
+
+#define main snacman_main
+#include "../snacman.cpp"
+#undef main
+
+// Run, cross now and then, rewind now and then
+void pressKeys(int frame) {
+    pressKey(KEY_LEFT_SHIFT);
+    if (frame % 37 == 5) {
+        pressKey(KEY_SPACE);
+    }
+    if (frame % 211 == 100) {
+        pressKey(KEY_Z);
+    }
+}
@@ -0,0 +1,186 @@
+// critter::makeMoveMap works on bitboards now. Checks it against the tile by
+// tile breadth-first search it replaced, starting from every wall tile of the
+// shipped levels, of generated levels, and of random ragged maps whose rows
+// straddle the 64-tile word boundaries, then from a few tiles of a wall that
+// winds back and forth across a whole map.
+#include <filesystem>
+#include <random>
+
+#include "harness.h"
+
+#define GENERATED_LEVELS 3
+#define RAGGED_MAPS 500
+#define RAGGED_MAX_WIDTH 140
+#define RAGGED_MAX_HEIGHT 40
+// Too many walls to start from every one, so just from each end and the middle
+#define SERPENTINE_SIZE 301
+
+// makeMoveMap as it was before bitboards, for reference
+vector<string> referenceMoveMap(V2 start, levelMap& map) {
+    vector<string> moveMap;
+    for (pmr::string& row : map) {
+        moveMap.push_back(string(row.begin(), row.end()));
+    }
+    auto ok = [&](V2 v) {
+        return v.y >= 0 && v.y < moveMap.size() && v.x >= 0 && v.x < moveMap[v.y].size();
+    };
+    list<V2> Q;
+    Q.push_back(start);
+    moveMap[start.y][start.x] = PATHWALL;
+    while (!Q.empty()) {
+        V2 next = *Q.begin();
+        Q.pop_front();
+        for (V2 plus : {V2(1, 0), V2(1, 1), V2(1, -1), V2(0, 1), V2(0, -1), V2(-1, 0), V2(-1, -1), V2(-1, 1)}) {
+            V2 adj = next + plus;
+            if (ok(adj)) {
+                if (moveMap[adj.y][adj.x] == WALL) {
+                    moveMap[adj.y][adj.x] = PATHWALL;
+                    Q.push_back(adj);
+                }
+                else if (moveMap[adj.y][adj.x] != PATHWALL) {
+                    moveMap[adj.y][adj.x] = PATH;
+                }
+            }
+        }
+    }
+    for (int row = 0; row < moveMap.size(); row++) {
+        for (int col = 0; col < moveMap[row].size(); col++) {
+            V2 pos(col, row);
+            if (moveMap[pos.y][pos.x] == APPLE || moveMap[pos.y][pos.x] == EMPTY || moveMap[pos.y][pos.x] == SNAKE || moveMap[pos.y][pos.x] == ENEMY) {
+                for (V2 diag : {V2(1, 1), V2(1, -1), V2(-1, 1), V2(-1, -1)}) {
+                    V2 adj = pos + diag;
+                    if (ok(adj) && moveMap[adj.y][adj.x] == PATHWALL) {
+                        moveMap[pos.y][pos.x] = PATH;
+                    }
+                }
+            }
+        }
+    }
+    return moveMap;
+}
+
+// Builds the move map both ways from one wall tile, reporting any difference
+bool compareFrom(V2 start, levelMap& map, bitboard& walls, critter& enemy, const string& name) {
+    vector<string> expected = referenceMoveMap(start, map);
+    enemy.makeMoveMap(start, map, walls);
+    levelMap& built = *enemy.moveMap;
+    for (int row = 0; row < map.size(); row++) {
+        if (expected[row] != string(built[row].begin(), built[row].end())) {
+            cerr << "movemap_test: " << name << ", starting from wall (" << start.x << ", " << start.y
+                 << "), row " << row << " is\n    " << built[row] << "\nbut should be\n    "
+                 << expected[row] << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Builds the move map both ways from every wall tile. Returns how many
+// starts were compared, or -1 after reporting the first difference.
+int compareAll(levelMap& map, const string& name) {
+    bitboard walls;
+    walls.fromMap(map, WALL);
+    critter enemy;
+    int starts = 0;
+    for (int y = 0; y < map.size(); y++) {
+        for (int x = 0; x < map[y].size(); x++) {
+            if (map[y][x] != WALL) {
+                continue;
+            }
+            if (!compareFrom(V2(x, y), map, walls, enemy, name)) {
+                return -1;
+            }
+            starts++;
+        }
+    }
+    return starts;
+}
+
+// One wall winding back and forth across the whole map, in columns or in
+// rows, so the flood has to double back on itself over and over
+levelMap serpentine(int size, bool sideways) {
+    levelMap map(size, pmr::string(size, EMPTY));
+    for (int lane = 1; lane < size - 1; lane += 2) {
+        for (int along = 1; along < size - 1; along++) {
+            (sideways ? map[lane][along] : map[along][lane]) = WALL;
+        }
+        if (lane + 2 < size - 1) {
+            int end = (lane / 2) % 2 ? 1 : size - 2;
+            (sideways ? map[lane + 1][end] : map[end][lane + 1]) = WALL;
+        }
+    }
+    return map;
+}
+
+int main() {
+    int maps = 0;
+    long starts = 0;
+    for (auto& entry : filesystem::directory_iterator("resources")) {
+        if (entry.path().extension() != ".lvl") {
+            continue;
+        }
+        mainData game;
+        game.readLevel(entry.path().string());
+        int compared = compareAll(game.map, entry.path().string());
+        if (compared < 0) {
+            return EXIT_FAILURE;
+        }
+        starts += compared;
+        maps++;
+    }
+    for (int i = 1; i <= GENERATED_LEVELS; i++) {
+        mainData game;
+        game.generateLevel();
+        int compared = compareAll(game.map, "generated level " + to_string(i));
+        if (compared < 0) {
+            return EXIT_FAILURE;
+        }
+        starts += compared;
+        maps++;
+    }
+
+    // Rows of any length, including none, and anything from a few walls to
+    // nearly all wall, so groups wrap round corners and run off row ends
+    mt19937 random(1);
+    const char tiles[] = {EMPTY, APPLE, SNAKE, ENEMY};
+    for (int i = 1; i <= RAGGED_MAPS; i++) {
+        int height = uniform_int_distribution<int>(1, RAGGED_MAX_HEIGHT)(random);
+        int widest = uniform_int_distribution<int>(1, RAGGED_MAX_WIDTH)(random);
+        double density = uniform_real_distribution<double>(0.05, 0.9)(random);
+        levelMap map;
+        for (int y = 0; y < height; y++) {
+            pmr::string row(uniform_int_distribution<int>(0, widest)(random), EMPTY);
+            for (char& tile : row) {
+                if (uniform_real_distribution<double>(0, 1)(random) < density) {
+                    tile = WALL;
+                }
+                else {
+                    tile = tiles[uniform_int_distribution<int>(0, 3)(random)];
+                }
+            }
+            map.push_back(row);
+        }
+        int compared = compareAll(map, "ragged map " + to_string(i));
+        if (compared < 0) {
+            return EXIT_FAILURE;
+        }
+        starts += compared;
+        maps++;
+    }
+    for (bool sideways : {false, true}) {
+        levelMap map = serpentine(SERPENTINE_SIZE, sideways);
+        bitboard walls;
+        walls.fromMap(map, WALL);
+        critter enemy;
+        string name = sideways ? "sideways serpentine" : "serpentine";
+        for (V2 start : {V2(1, 1), V2(SERPENTINE_SIZE / 2 + 1, SERPENTINE_SIZE / 2 + 1), V2(SERPENTINE_SIZE - 2, SERPENTINE_SIZE - 2)}) {
+            if (!compareFrom(start, map, walls, enemy, name)) {
+                return EXIT_FAILURE;
+            }
+            starts++;
+        }
+        maps++;
+    }
+    cout << "movemap_test: " << maps << " maps, " << starts << " starting walls, all the same as the old search\n";
+    return EXIT_SUCCESS;
+}
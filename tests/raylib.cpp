@@ -0,0 +1,147 @@
+#include <cstdarg>
+#include <cstdlib>
+#include <set>
+
+#include "raylib.h"
+
+using namespace std;
+
+// Handles handed out and not given back yet. Textures and sounds draw ids
+// from the same counter, so mixing them up shows as an unknown id.
+static set<unsigned int> textures;
+static set<unsigned int> sounds;
+static unsigned int nextId = 1;
+static set<int> keysPressed;
+static unsigned int seed = 1;
+
+static unsigned int load(set<unsigned int>& live) {
+    live.insert(nextId);
+    return nextId++;
+}
+
+static void unload(set<unsigned int>& live, unsigned int id, const char* what) {
+    if (live.erase(id) == 0) {
+        fprintf(stderr, "Unloaded %s %u, which isn't loaded\n", what, id);
+        abort();
+    }
+}
+
+int liveTextures() {
+    return textures.size();
+}
+
+int liveSounds() {
+    return sounds.size();
+}
+
+void pressKey(int key) {
+    keysPressed.insert(key);
+}
+
+void InitWindow(int width, int height, const char* title) {}
+bool WindowShouldClose(void) { return false; }
+void SetConfigFlags(unsigned int flags) {}
+void SetTargetFPS(int fps) {}
+void InitAudioDevice(void) {}
+
+void BeginDrawing(void) {}
+
+void EndDrawing(void) {
+    keysPressed.clear();
+}
+
+void BeginTextureMode(RenderTexture2D target) {}
+void EndTextureMode(void) {}
+void ClearBackground(Color color) {}
+void DrawRectangle(int x, int y, int width, int height, Color color) {}
+void DrawLineV(Vector2 start, Vector2 end, Color color) {}
+void DrawText(const char* text, int x, int y, int size, Color color) {}
+void DrawTexture(Texture2D texture, int x, int y, Color tint) {}
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint) {}
+void DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint) {}
+
+Color Fade(Color color, float alpha) {
+    return color;
+}
+
+const char* TextFormat(const char* text, ...) {
+    static char buffer[256];
+    va_list args;
+    va_start(args, text);
+    vsnprintf(buffer, sizeof(buffer), text, args);
+    va_end(args);
+    return buffer;
+}
+
+Image LoadImage(const char* fileName) {
+    return Image{nullptr, 32, 32, 1, 0};
+}
+
+void ImageResize(Image* image, int width, int height) {}
+void UnloadImage(Image image) {}
+
+Texture2D LoadTexture(const char* fileName) {
+    return Texture2D{load(textures), 32, 32, 1, 0};
+}
+
+Texture2D LoadTextureFromImage(Image image) {
+    return LoadTexture("");
+}
+
+// Like raylib, id 0 is no texture and unloading it does nothing
+void UnloadTexture(Texture2D texture) {
+    if (texture.id > 0) {
+        unload(textures, texture.id, "texture");
+    }
+}
+
+RenderTexture2D LoadRenderTexture(int width, int height) {
+    RenderTexture2D target = {};
+    target.texture = LoadTexture("");
+    target.id = target.texture.id;
+    return target;
+}
+
+void UnloadRenderTexture(RenderTexture2D target) {
+    UnloadTexture(target.texture);
+}
+
+Sound LoadSound(const char* fileName) {
+    Sound sound = {};
+    sound.sampleCount = load(sounds);
+    return sound;
+}
+
+void UnloadSound(Sound sound) {
+    unload(sounds, sound.sampleCount, "sound");
+}
+
+void PlaySound(Sound sound) {}
+
+Music LoadMusicStream(const char* fileName) {
+    Music music = {};
+    music.sampleCount = load(sounds);
+    return music;
+}
+
+void UnloadMusicStream(Music music) {
+    unload(sounds, music.sampleCount, "music");
+}
+
+void PlayMusicStream(Music music) {}
+void StopMusicStream(Music music) {}
+void UpdateMusicStream(Music music) {}
+
+bool IsKeyPressed(int key) {
+    return keysPressed.count(key) > 0;
+}
+
+bool IsKeyDown(int key) {
+    return keysPressed.count(key) > 0;
+}
+
+// Fixed sequence, so runs repeat exactly
+int GetRandomValue(int min, int max) {
+    seed = seed * 1103515245 + 12345;
+    return min + (seed >> 8) % (max - min + 1);
+}
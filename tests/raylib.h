@@ -0,0 +1,82 @@
+// Stand-in for raylib, just enough to build snacman.cpp headless for the
+// tests. Nothing is drawn or played; loaded textures and sounds are only
+// counted, so the tests can check that everything loaded gets unloaded.
+#pragma once
+#include <cstdio>
+
+typedef struct Vector2 { float x, y; } Vector2;
+typedef struct Rectangle { float x, y, width, height; } Rectangle;
+typedef struct Color { unsigned char r, g, b, a; } Color;
+typedef struct Image { void* data; int width, height, mipmaps, format; } Image;
+typedef struct Texture2D { unsigned int id; int width, height, mipmaps, format; } Texture2D;
+typedef Texture2D Texture;
+typedef struct RenderTexture2D { unsigned int id; Texture2D texture; Texture2D depth; } RenderTexture2D;
+typedef struct AudioStream { void* buffer; unsigned int sampleRate, sampleSize, channels; } AudioStream;
+typedef struct Sound { AudioStream stream; unsigned int sampleCount; } Sound;
+typedef struct Music { AudioStream stream; unsigned int sampleCount; bool looping; int ctxType; void* ctxData; } Music;
+
+#define WHITE (Color){255, 255, 255, 255}
+#define BLACK (Color){0, 0, 0, 255}
+#define BLUE (Color){0, 121, 241, 255}
+#define GREEN (Color){0, 228, 48, 255}
+#define RED (Color){230, 41, 55, 255}
+#define YELLOW (Color){253, 249, 0, 255}
+#define PURPLE (Color){200, 122, 255, 255}
+
+#define FLAG_WINDOW_HIDDEN 0x00000080
+
+enum {
+    KEY_SPACE = 32,
+    KEY_R = 82,
+    KEY_Z = 90,
+    KEY_BACKSPACE = 259,
+    KEY_LEFT_SHIFT = 340,
+};
+
+void InitWindow(int width, int height, const char* title);
+bool WindowShouldClose(void);
+void SetConfigFlags(unsigned int flags);
+void SetTargetFPS(int fps);
+void InitAudioDevice(void);
+
+void BeginDrawing(void);
+void EndDrawing(void);
+void BeginTextureMode(RenderTexture2D target);
+void EndTextureMode(void);
+void ClearBackground(Color color);
+void DrawRectangle(int x, int y, int width, int height, Color color);
+void DrawLineV(Vector2 start, Vector2 end, Color color);
+void DrawText(const char* text, int x, int y, int size, Color color);
+void DrawTexture(Texture2D texture, int x, int y, Color tint);
+void DrawTextureRec(Texture2D texture, Rectangle source, Vector2 position, Color tint);
+void DrawTexturePro(Texture2D texture, Rectangle source, Rectangle dest, Vector2 origin, float rotation, Color tint);
+Color Fade(Color color, float alpha);
+const char* TextFormat(const char* text, ...);
+
+Image LoadImage(const char* fileName);
+void ImageResize(Image* image, int width, int height);
+void UnloadImage(Image image);
+Texture2D LoadTexture(const char* fileName);
+Texture2D LoadTextureFromImage(Image image);
+void UnloadTexture(Texture2D texture);
+RenderTexture2D LoadRenderTexture(int width, int height);
+void UnloadRenderTexture(RenderTexture2D target);
+
+Sound LoadSound(const char* fileName);
+void UnloadSound(Sound sound);
+void PlaySound(Sound sound);
+Music LoadMusicStream(const char* fileName);
+void UnloadMusicStream(Music music);
+void PlayMusicStream(Music music);
+void StopMusicStream(Music music);
+void UpdateMusicStream(Music music);
+
+bool IsKeyPressed(int key);
+bool IsKeyDown(int key);
+int GetRandomValue(int min, int max);
+
+// Test hooks, not part of raylib
+int liveTextures();
+int liveSounds();
+// Held down for the next frame only
+void pressKey(int key);
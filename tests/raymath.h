@@ -0,0 +1,15 @@
+// Stand-in for raymath, see raylib.h
+#pragma once
+#include "raylib.h"
+
+static inline Vector2 Vector2Add(Vector2 a, Vector2 b) {
+    return {a.x + b.x, a.y + b.y};
+}
+
+static inline Vector2 Vector2Subtract(Vector2 a, Vector2 b) {
+    return {a.x - b.x, a.y - b.y};
+}
+
+static inline Vector2 Vector2Scale(Vector2 v, float scale) {
+    return {v.x * scale, v.y * scale};
+}
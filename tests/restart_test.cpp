@@ -0,0 +1,106 @@
+// Restarting has to give back everything the old level loaded. Plays a
+// while on good.lvl, presses R, and checks that the live texture and sound
+// counts and the resident set size stay put over many restarts. Where there's
+// no <memory_resource>, levelMemory's release does nothing and the level goes
+// back piece by piece, which the resident set can't tell apart, so before
+// each restart it also checks that the level really was built on levelMemory.
+#include <unistd.h>
+
+#include "harness.h"
+
+#define RESTARTS 200
+#define FRAMES_PER_GAME 600
+// Restarts to run before taking the resident set size to compare against
+#define WARMUP_RESTARTS 20
+// Growth allowed past that, for allocator noise
+#define RSS_SLACK_KB 1024
+
+long residentKB() {
+    ifstream statm("/proc/self/statm");
+    long pages, resident;
+    if (!(statm >> pages >> resident)) {
+        return -1;
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+template <class T>
+bool inLevel(const T& container) {
+    return container.get_allocator().resource() == &levelMemory;
+}
+
+bool inLevel(levelMap& map) {
+    return map.get_allocator().resource() == &levelMemory
+        && all_of(map.begin(), map.end(), [](pmr::string& row) { return inLevel(row); });
+}
+
+// Empty if all the level's state draws from levelMemory, otherwise what doesn't
+string outsideLevel(mainData& game) {
+    if (!inLevel(game.map) || !inLevel(game.walls.bits)) {
+        return "map";
+    }
+    if (!inLevel(*game.s.moveMap) || !inLevel(game.s.segments) || !inLevel(game.s.moveQueue)) {
+        return "snake";
+    }
+    if (!inLevel(game.spiders)) {
+        return "spider list";
+    }
+    for (spider& enemy : game.spiders) {
+        if (!inLevel(*enemy.moveMap) || !inLevel(enemy.segments)) {
+            return "spider " + to_string(enemy.id);
+        }
+    }
+    if (!inLevel(game.zones.layout->firstZone) || !inLevel(game.zones.layout->zoneList) || !inLevel(game.zones.snakeTiles)) {
+        return "zones";
+    }
+    if (!inLevel(game.history.ticks) || !inLevel(game.history.moveMapBefore)) {
+        return "rewind history";
+    }
+    for (tickUndo& undo : game.history.ticks) {
+        if (!inLevel(undo.snake.tiles) || !inLevel(undo.snake.shed) || !inLevel(undo.spiderMoves)
+            || !inLevel(undo.caught) || !inLevel(undo.caughtAt) || !inLevel(undo.moveMapBefore)) {
+            return "rewind history";
+        }
+    }
+    return "";
+}
+
+int main() {
+    char name[] = "snacman";
+    char level[] = "resources/good.lvl";
+    char* argv[] = {name, level};
+    initEverything(2, argv);
+    int textures = liveTextures();
+    int sounds = liveSounds();
+    long warmRSS = -1;
+    for (int restart = 1; restart <= RESTARTS; restart++) {
+        for (int frame = 0; frame < FRAMES_PER_GAME; frame++) {
+            pressKeys(frame);
+            doEverything();
+        }
+        string outside = outsideLevel(*everything);
+        if (!outside.empty()) {
+            cerr << "restart_test: before restart " << restart << ", part of the level (" << outside
+                 << ") was built outside levelMemory, so restarting won't give it back\n";
+            return EXIT_FAILURE;
+        }
+        pressKey(KEY_R);
+        doEverything();
+        if (liveTextures() != textures || liveSounds() != sounds) {
+            cerr << "restart_test: after restart " << restart << ", " << liveTextures() << " textures and "
+                 << liveSounds() << " sounds are loaded, expected " << textures << " and " << sounds << "\n";
+            return EXIT_FAILURE;
+        }
+        if (restart == WARMUP_RESTARTS) {
+            warmRSS = residentKB();
+        }
+    }
+    long rss = residentKB();
+    if (warmRSS >= 0 && rss > warmRSS + RSS_SLACK_KB) {
+        cerr << "restart_test: resident set grew from " << warmRSS << " KB to " << rss << " KB\n";
+        return EXIT_FAILURE;
+    }
+    cout << "restart_test: " << RESTARTS << " restarts, " << textures << " textures and " << sounds
+         << " sounds loaded throughout, resident set " << warmRSS << " KB -> " << rss << " KB\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+// Rewinding plays ticks backwards from what each one recorded, so it has to
+// land exactly where the game was. Plays good.lvl and random levels, crossing
+// between ticks, saving everything a tick can change after each one, and
+// after every press of Z requires the game to match what was saved
+// REWIND_STEP ticks back, caught spiders included.
+#include "harness.h"
+
+#define GAMES 10
+#define FRAMES_PER_GAME 1500
+
+// Everything a tick or a crossing can change
+struct savedState {
+    vector<string> map;
+    vector<string> moveMap;
+    vector<segment> segments;
+    vector<segment> moveQueue;
+    int clockwise;
+    int snakeSize;
+    int totalApples;
+    vector<int> spiderIds;
+    vector<vector<segment>> spiders;
+    vector<int> snakeTiles;
+};
+
+vector<string> rows(levelMap& map) {
+    vector<string> copy;
+    for (pmr::string& row : map) {
+        copy.push_back(string(row.begin(), row.end()));
+    }
+    return copy;
+}
+
+savedState save(mainData& game) {
+    savedState state;
+    state.map = rows(game.map);
+    state.moveMap = rows(*game.s.moveMap);
+    state.segments.assign(game.s.segments.begin(), game.s.segments.end());
+    state.moveQueue.assign(game.s.moveQueue.begin(), game.s.moveQueue.end());
+    state.clockwise = game.s.c.clockwise;
+    state.snakeSize = game.s.snakeSize;
+    state.totalApples = game.totalApples;
+    for (spider& enemy : game.spiders) {
+        state.spiderIds.push_back(enemy.id);
+        state.spiders.push_back(vector<segment>(enemy.segments.begin(), enemy.segments.end()));
+    }
+    state.snakeTiles.assign(game.zones.snakeTiles.begin(), game.zones.snakeTiles.end());
+    return state;
+}
+
+bool sameSegments(const vector<segment>& a, const vector<segment>& b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), sameSegment);
+}
+
+// Empty if the game is back to state, otherwise what's different
+string differences(mainData& game, savedState& state) {
+    savedState now = save(game);
+    if (now.map != state.map) {
+        return "map";
+    }
+    if (now.moveMap != state.moveMap) {
+        return "snake's move map";
+    }
+    if (!sameSegments(now.segments, state.segments)) {
+        return "snake";
+    }
+    if (!sameSegments(now.moveQueue, state.moveQueue)) {
+        return "move queue";
+    }
+    if (now.clockwise != state.clockwise) {
+        return "snake's direction round the wall";
+    }
+    if (now.snakeSize != state.snakeSize || now.totalApples != state.totalApples) {
+        return "score";
+    }
+    if (now.spiderIds != state.spiderIds) {
+        return "spiders";
+    }
+    for (int i = 0; i < now.spiders.size(); i++) {
+        if (!sameSegments(now.spiders[i], state.spiders[i])) {
+            return "spider " + to_string(now.spiderIds[i]);
+        }
+    }
+    if (now.snakeTiles != state.snakeTiles) {
+        return "snake tiles per zone";
+    }
+    return "";
+}
+
+// Over all the games, so main can check both kinds of undo got tried
+long crossingsTakenBack = 0;
+long spidersBroughtBack = 0;
+
+bool rewindGames(int argc, char** argv) {
+    initEverything(argc, argv);
+    long rewinds = 0;
+    long crossingsBefore = crossingsTakenBack;
+    long spidersBefore = spidersBroughtBack;
+    for (int game = 1; game <= GAMES; game++) {
+        // The state after each tick the game can still rewind, and before them all
+        deque<savedState> states = {save(*everything)};
+        // Set when a tick catches a spider, to rewind straight after
+        bool justCaught = false;
+        for (int frame = 0; frame < FRAMES_PER_GAME; frame++) {
+            mainData& g = *everything;
+            // Crossing or rewinding on a tick's frame would happen after the
+            // tick, before its state could be saved, so keep them in between
+            bool tickFrame = g.playing() && g.tickCount % FASTTICK == 0;
+            bool rewinding = !tickFrame && (frame % 97 == 50 || justCaught);
+            pressKey(KEY_LEFT_SHIFT);
+            if (!tickFrame && (frame % 37 == 5 || frame % 37 == 7)) {
+                pressKey(KEY_SPACE);
+            }
+            if (rewinding) {
+                pressKey(KEY_Z);
+            }
+            int crossings = g.history.crossings;
+            for (int i = max(0, (int)g.history.ticks.size() - REWIND_STEP); i < g.history.ticks.size(); i++) {
+                crossings += g.history.ticks[i].crossings;
+            }
+            int spiders = g.spiders.size();
+            doEverything();
+            if (rewinding) {
+                for (int i = 0; i < REWIND_STEP && states.size() > 1; i++) {
+                    states.pop_back();
+                }
+                string wrong = differences(g, states.back());
+                if (!wrong.empty()) {
+                    cerr << "rewind_test: " << argv[1] << " game " << game << " frame " << frame
+                         << ": after rewinding, the " << wrong << " doesn't match\n";
+                    return false;
+                }
+                rewinds++;
+                crossingsTakenBack += crossings;
+                spidersBroughtBack += g.spiders.size() - spiders;
+                justCaught = false;
+            }
+            else if (g.ticked) {
+                justCaught = justCaught || g.spiders.size() < spiders;
+                states.push_back(save(g));
+                if (states.size() > REWIND_TICKS + 1) {
+                    states.pop_front();
+                }
+            }
+            if (g.history.ticks.size() != states.size() - 1) {
+                cerr << "rewind_test: " << argv[1] << " game " << game << " frame " << frame << ": the game keeps "
+                     << g.history.ticks.size() << " ticks to rewind, but the test saved " << states.size() - 1 << "\n";
+                return false;
+            }
+        }
+        pressKey(KEY_R);
+        doEverything();
+    }
+    cout << "rewind_test: " << argv[1] << ", " << rewinds << " rewinds matched, taking back "
+         << crossingsTakenBack - crossingsBefore << " crossings and " << spidersBroughtBack - spidersBefore
+         << " caught spiders\n";
+    return true;
+}
+
+int main() {
+    char name[] = "snacman";
+    char level[] = "resources/good.lvl";
+    char random[] = "random";
+    char* goodArgv[] = {name, level};
+    char* randomArgv[] = {name, random};
+    if (!rewindGames(2, goodArgv) || !rewindGames(2, randomArgv)) {
+        return EXIT_FAILURE;
+    }
+    if (crossingsTakenBack == 0 || spidersBroughtBack == 0) {
+        cerr << "rewind_test: no rewind took back a crossing or a caught spider, so those went untested\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+// Spectators only ever see the snapshot stream, so what they rebuild from it
+// has to match the game exactly. Plays good.lvl and random levels, feeding
+// every frame snapshotWriter::encode makes straight into a snapshotReader and
+// comparing map, snake, spiders and score after each one. Then streams
+// through a real FIFO, lets the spectator leave, and checks that the next
+// one to open it is brought up to date.
+#include <cstdlib>
+#include <sys/stat.h>
+
+#include "harness.h"
+
+#define GAMES 20
+#define FRAMES_PER_GAME 1500
+#define FIFO_FRAMES 300
+// encodeDelta falls back to a keyframe when its replica goes wrong, which
+// hides mistakes, so also check that keyframes only come when they have to:
+// once per level and every KEYFRAME_INTERVAL ticks, but never for a rewind.
+
+// Empty if the spectator sees what the game has, otherwise what's different
+string differences(mainData& game, snapshotState& seen) {
+    if (seen.mapWidth != game.mapWidth || seen.map.size() != game.map.size()) {
+        return "map size";
+    }
+    for (int row = 0; row < game.map.size(); row++) {
+        if (seen.map[row] != string(game.map[row].begin(), game.map[row].end())) {
+            return "map row " + to_string(row);
+        }
+    }
+    if (seen.snake.size() != game.s.segments.size()
+        || !equal(seen.snake.begin(), seen.snake.end(), game.s.segments.begin(), sameSegment)) {
+        return "snake";
+    }
+    if (seen.spiders.size() != game.spiders.size()) {
+        return "spider count";
+    }
+    auto enemy = game.spiders.begin();
+    for (V2& head : seen.spiders) {
+        if (head != enemy->segments.front().pos) {
+            return "spider " + to_string(enemy->id);
+        }
+        enemy++;
+    }
+    if (seen.snakeSize != game.s.snakeSize || seen.totalApples != game.totalApples) {
+        return "score";
+    }
+    return "";
+}
+
+bool loopback(int argc, char** argv) {
+    initEverything(argc, argv);
+    snapshotReader reader;
+    long ticks = 0;
+    long keyframes = 0;
+    long wholeSnakes = 0;
+    long bytes = 0;
+    for (int game = 1; game <= GAMES; game++) {
+        for (int frame = 0; frame <= FRAMES_PER_GAME; frame++) {
+            if (frame < FRAMES_PER_GAME) {
+                pressKeys(frame);
+            }
+            else {
+                pressKey(KEY_R);
+            }
+            doEverything();
+            if (!everything->ticked && broadcast.valid) {
+                continue;
+            }
+            string frameData = broadcast.encode(*everything);
+            bytes += frameData.size();
+            ticks++;
+            snapshotCursor header(frameData, 0, frameData.size());
+            header.varint();
+            keyframes += (frameData[header.pos] & SNAP_KEYFRAME) != 0;
+            wholeSnakes += (frameData[header.pos] & (SNAP_KEYFRAME | SNAP_WHOLE_SNAKE)) == SNAP_WHOLE_SNAKE;
+            if (!reader.feed(frameData.data(), frameData.size())) {
+                cerr << "snapshot_test: " << argv[1] << " game " << game << " frame " << frame
+                     << ": the reader didn't take a whole tick\n";
+                return false;
+            }
+            string wrong = differences(*everything, reader.state);
+            if (!wrong.empty()) {
+                cerr << "snapshot_test: " << argv[1] << " game " << game << " frame " << frame
+                     << ": the spectator's " << wrong << " doesn't match the game\n";
+                return false;
+            }
+        }
+    }
+    // The first level, then one per restart
+    long levels = GAMES + 1;
+    if (keyframes > levels + ticks / KEYFRAME_INTERVAL) {
+        cerr << "snapshot_test: " << argv[1] << ", " << keyframes << " of " << ticks << " ticks were keyframes, "
+             << "over " << levels << " levels\n";
+        return false;
+    }
+    // Rewinds and being caught send the whole snake in a delta
+    if (wholeSnakes == 0) {
+        cerr << "snapshot_test: " << argv[1] << ", no delta ever sent the whole snake\n";
+        return false;
+    }
+    cout << "snapshot_test: " << argv[1] << ", " << ticks << " ticks matched, " << keyframes << " of them keyframes and "
+         << wholeSnakes << " deltas with the whole snake, " << TextFormat("%.1f", (double)bytes / ticks) << " bytes a tick\n";
+    return true;
+}
+
+// Reads whatever is waiting on the FIFO, then checks it against the game
+bool caughtUp(snapshotReader& reader, const char* who) {
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(reader.fd, chunk, sizeof(chunk))) > 0) {
+        reader.feed(chunk, n);
+    }
+    string wrong = reader.synced ? differences(*everything, reader.state) : "whole game";
+    if (!wrong.empty()) {
+        cerr << "snapshot_test: the " << who << " spectator's " << wrong << " doesn't match the game\n";
+        return false;
+    }
+    return true;
+}
+
+bool reconnecting(int argc, char** argv) {
+    char dir[] = "/tmp/snapshot_testXXXXXX";
+    if (!mkdtemp(dir)) {
+        cerr << "snapshot_test: couldn't make a directory for the FIFO\n";
+        return false;
+    }
+    string path = string(dir) + "/stream";
+    bool passed = mkfifo(path.c_str(), 0600) == 0;
+
+    // A reader is already waiting, so opening the writer end won't block
+    snapshotReader first;
+    passed = passed && first.openStream(path.c_str()) && broadcast.openStream(path.c_str());
+    initEverything(argc, argv);
+    // As if freshly started, so the loopback games above don't count
+    broadcast.valid = false;
+    for (int frame = 0; passed && frame < FIFO_FRAMES; frame++) {
+        pressKeys(frame);
+        doEverything();
+        passed = caughtUp(first, "first");
+    }
+
+    close(first.fd);
+    for (int frame = 0; passed && frame < FIFO_FRAMES && !broadcast.reopen; frame++) {
+        pressKeys(frame);
+        doEverything();
+    }
+    if (passed && !broadcast.reopen) {
+        cerr << "snapshot_test: the writer didn't notice its spectator leave\n";
+        passed = false;
+    }
+
+    snapshotReader second;
+    passed = passed && second.openStream(path.c_str());
+    for (int frame = 0; passed && frame < FIFO_FRAMES; frame++) {
+        pressKeys(frame);
+        doEverything();
+        passed = caughtUp(second, "second");
+    }
+
+    if (broadcast.fd >= 0) {
+        close(broadcast.fd);
+        broadcast.fd = -1;
+    }
+    if (second.fd >= 0) {
+        close(second.fd);
+    }
+    unlink(path.c_str());
+    rmdir(dir);
+    if (passed) {
+        cout << "snapshot_test: a second spectator caught up after the first left\n";
+    }
+    return passed;
+}
+
+int main() {
+    char name[] = "snacman";
+    char level[] = "resources/good.lvl";
+    char random[] = "random";
+    char* goodArgv[] = {name, level};
+    char* randomArgv[] = {name, random};
+    if (!loopback(2, goodArgv) || !loopback(2, randomArgv) || !reconnecting(2, goodArgv)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
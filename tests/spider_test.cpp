@@ -0,0 +1,107 @@
+// spider::doTick's search keeps parents in a flat array now. Checks it
+// against the unordered_map search it replaced: plays good.lvl and random
+// levels, and after every tick moves a copy of each spider both ways from
+// the same map, requiring the same segments and the same catches, and that
+// spiders with no snake in their zone don't move at all.
+#include "harness.h"
+
+#define GAMES 20
+#define FRAMES_PER_GAME 1500
+
+// spider::doTick as it was before the flat array, for reference
+bool referenceTick(spider& enemy, levelMap& map) {
+    V2 head = enemy.segments.begin()->pos;
+    V2 tail = enemy.segments.rbegin()->pos;
+    if (map[head.y][head.x] == SNAKE || map[tail.y][tail.x] == SNAKE) {
+        return true;
+    }
+    list<V2> Q;
+    Q.push_back(enemy.segments.begin()->pos);
+    unordered_map<int, V2> parents;
+    while (!Q.empty()) {
+        V2 next = *Q.begin();
+        Q.pop_front();
+        for (int i = 0; i < 4; i++) {
+            V2 adj = next + enemy.c.cardinal[i];
+            if (enemy.ok(adj) && (*enemy.moveMap)[adj.y][adj.x] == PATH && parents.count(adj.hash()) == 0) {
+                parents[adj.hash()] = next;
+                Q.push_back(adj);
+                if (map[adj.y][adj.x] == SNAKE) {
+                    while (parents[next.hash()] != head && next != head) {
+                        next = parents[next.hash()];
+                    }
+                    enemy.segments.begin()->forward = next - head;
+                    segment next = enemy.getNextSegment();
+                    enemy.segments.push_front(next);
+                    enemy.segments.pop_back();
+                }
+            }
+        }
+    }
+    return false;
+}
+
+bool sameSegments(pmr::list<segment>& a, pmr::list<segment>& b) {
+    return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(), sameSegment);
+}
+
+bool compareGames(int argc, char** argv) {
+    initEverything(argc, argv);
+    long checks = 0;
+    long moves = 0;
+    long asleep = 0;
+    for (int game = 1; game <= GAMES; game++) {
+        for (int frame = 0; frame <= FRAMES_PER_GAME; frame++) {
+            if (frame < FRAMES_PER_GAME) {
+                pressKeys(frame);
+            }
+            else {
+                pressKey(KEY_R);
+            }
+            doEverything();
+            if (!everything->ticked) {
+                continue;
+            }
+            mainData& g = *everything;
+            for (spider& enemy : g.spiders) {
+                spider flat = enemy;
+                spider reference = enemy;
+                flat.quiet = true;
+                bool flatCaught = flat.doTick(g.map);
+                bool referenceCaught = referenceTick(reference, g.map);
+                if (flatCaught != referenceCaught || !sameSegments(flat.segments, reference.segments)) {
+                    cerr << "spider_test: " << argv[1] << " game " << game << " frame " << frame << ": spider "
+                         << enemy.id << " went a different way from the old search\n";
+                    return false;
+                }
+                checks++;
+                moves += !sameSegments(flat.segments, enemy.segments);
+                // step skips spiders with no snake in their zone, which is
+                // only safe if they'd have done nothing anyway
+                if (!g.zones.occupied(enemy.zone)) {
+                    if (flatCaught || !sameSegments(flat.segments, enemy.segments)) {
+                        cerr << "spider_test: " << argv[1] << " game " << game << " frame " << frame << ": spider "
+                             << enemy.id << " would have moved while asleep\n";
+                        return false;
+                    }
+                    asleep++;
+                }
+            }
+        }
+    }
+    cout << "spider_test: " << argv[1] << ", " << checks << " spider ticks the same as the old search, "
+         << moves << " of them moves, " << asleep << " asleep and staying put\n";
+    return true;
+}
+
+int main() {
+    char name[] = "snacman";
+    char level[] = "resources/good.lvl";
+    char random[] = "random";
+    char* goodArgv[] = {name, level};
+    char* randomArgv[] = {name, random};
+    if (!compareGames(2, goodArgv) || !compareGames(2, randomArgv)) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}